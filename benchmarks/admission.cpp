@@ -0,0 +1,101 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1254u;
+constexpr auto peerLimit = 64u;
+constexpr unsigned floodSizes[] = {0, 16, 64, 256};
+
+using Clock = std::chrono::steady_clock;
+using ms = std::chrono::duration<double, std::milli>;
+
+struct Result {
+    size_t halfOpen; // peers allocated to the flood
+    double connect; // ms for a real client to connect, negative if it failed
+    size_t challenged;
+};
+
+size_t countHalfOpen(Host& host)
+{
+    auto& enet = *static_cast<ENetHost*>(host);
+    auto count = size_t(0);
+    for (auto i = 0u; i < enet.peerCount; ++i) {
+        count += enet.peers[i].state != ENET_PEER_STATE_DISCONNECTED;
+    }
+    return count;
+}
+
+Result test(size_t sources, bool admission)
+{
+    Host server{Address{port}, peerLimit};
+    server.setAdmission(admission);
+
+    // every source sends its connection attempt and goes silent, as spoofed
+    // ones would, ENet keeps resending the verification until it times out
+    std::vector<std::unique_ptr<Host>> flood;
+    for (auto i = 0u; i < sources; ++i) {
+        flood.push_back(std::make_unique<Host>());
+        flood.back()->connect({"localhost", port});
+        flood.back()->flush();
+    }
+    for (const auto end = Clock::now() + ms{200}; Clock::now() < end;) {
+        server.service(1_ms);
+    }
+    const auto halfOpen = countHalfOpen(server);
+
+    Host client{};
+    client.setAdmission(admission);
+    auto connected = false;
+    client.onConnect([&connected](Peer&, uint32_t) { connected = true; });
+
+    const auto start = Clock::now();
+    client.connect({"localhost", port});
+    while (!connected && Clock::now() - start < ms{5000}) {
+        server.service();
+        client.service(1_ms);
+    }
+
+    return {
+        halfOpen,
+        connected ? ms(Clock::now() - start).count() : -1,
+        server.getAdmissionStats().challenged
+    };
+}
+
+void print(const Result& result)
+{
+    std::cout << std::setw(12) << result.halfOpen
+              << std::setw(12) << result.challenged;
+    if (result.connect < 0) std::cout << std::setw(14) << "failed";
+    else std::cout << std::setw(12) << result.connect << "ms";
+}
+
+int main()
+{
+    std::cout << "Connection attempts from sources that never answer, "
+              << "server with " << peerLimit << " peers\n"
+              << std::setw(8) << "Sources"
+              << std::setw(38) << "Baseline"
+              << "   |" << std::setw(38) << "Admission" << std::endl
+              << std::setw(8) << ""
+              << std::setw(12) << "Half-open" << std::setw(12) << "Cookies"
+              << std::setw(14) << "Connect" << "   |"
+              << std::setw(12) << "Half-open" << std::setw(12) << "Cookies"
+              << std::setw(14) << "Connect" << std::endl;
+
+    for (auto sources : floodSizes) {
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(8) << sources;
+        print(test(sources, false));
+        std::cout << "   |";
+        print(test(sources, true));
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,62 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto operations = 20000000u;
+constexpr auto slots = 4096u; // blocks alive at once
+
+using Clock = std::chrono::steady_clock;
+using ns = std::chrono::duration<double, std::nano>;
+
+template <typename Allocate, typename Release>
+void test(const char* name, const std::vector<size_t>& sizes,
+          Allocate allocate, Release release)
+{
+    std::vector<void*> blocks(slots);
+    const auto start = Clock::now();
+    for (auto i = 0u; i < operations; ++i) {
+        auto& block = blocks[i % slots];
+        release(block);
+        block = allocate(sizes[i % sizes.size()]);
+    }
+    for (auto block : blocks) release(block);
+    const auto elapsed = ns(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(12) << name
+              << std::setw(12) << elapsed / operations << "ns" << std::endl;
+}
+
+int main()
+{
+    Allocator::install();
+
+    // commands, acknowledgements, packets up to the MTU, peer sized blocks
+    std::mt19937 random{42};
+    std::vector<size_t> sizes(65536);
+    const size_t common[] = {24, 48, 72, 96, 120, 1400, 1500, 8000};
+    for (auto& size : sizes) size = common[random() % 8] + random() % 16;
+
+    std::cout << std::setw(12) << "Allocator"
+              << std::setw(14) << "Per pair" << std::endl;
+
+    test("malloc", sizes, std::malloc, std::free);
+    test("Allocator", sizes, Allocator::allocate, Allocator::release);
+
+    const auto before = Host::getAllocatorStats();
+    {
+        Host host{Address{1246}, 4096};
+        const auto after = Host::getAllocatorStats();
+        std::cout << "4096 peer host: " << after.live - before.live
+                  << " bytes live, " << after.allocations - before.allocations
+                  << " allocations" << std::endl;
+    }
+}
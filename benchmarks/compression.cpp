@@ -0,0 +1,200 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto messages = 100000u;
+constexpr auto port = 1241u;
+constexpr auto maxRecipients = 256u;
+constexpr auto broadcasts = 200u;
+
+using Clock = std::chrono::steady_clock;
+using ns = std::chrono::duration<double, std::nano>;
+
+// Chat and state updates that repeat most of their structure
+std::vector<std::vector<byte>> makeMessages()
+{
+    const char* names[] = {"alice", "bob", "carol", "dave", "eve"};
+    const char* items[] = {"sword", "shield", "potion", "arrow", "bow"};
+
+    std::mt19937 random{42};
+    std::vector<std::vector<byte>> result(1024);
+    for (auto& message : result) {
+        auto text = std::string{"{\"type\":\"update\",\"player\":\""} +
+                    names[random() % 5] + "\",\"health\":" +
+                    std::to_string(random() % 100) + ",\"inventory\":[";
+        for (auto i = 0u; i < 4; ++i) {
+            text += std::string{i ? "," : ""} + "\"" + items[random() % 5] +
+                    "\"";
+        }
+        text += "],\"position\":[" + std::to_string(random() % 1000) + "," +
+                std::to_string(random() % 1000) + "]}";
+        message.assign(text.begin(), text.end());
+    }
+    return result;
+}
+
+template <typename Compress>
+void test(const char* name, const std::vector<std::vector<byte>>& data,
+          Compress compress)
+{
+    auto in = size_t(0), out = size_t(0);
+    const auto start = Clock::now();
+    for (auto i = 0u; i < messages; ++i) {
+        const auto& message = data[i % data.size()];
+        in += message.size();
+        out += compress(message);
+    }
+    const auto elapsed = ns(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(24) << name
+              << std::setw(12) << double(out) / in
+              << std::setw(12) << std::setprecision(0) << elapsed / messages
+              << "ns" << std::endl;
+}
+
+enum class Mode { None, Datagram, Packet };
+
+template <typename Comp>
+void setMode(Host& host, Mode mode)
+{
+    if (mode == Mode::Datagram) host.setCompression<Comp>();
+    if (mode == Mode::Packet) host.setPacketCompression<Comp>(0);
+}
+
+// Time of a broadcast and the flush putting it on the wire (where ENet
+// compresses datagrams) for every number of recipients, in microseconds
+std::vector<double> testBroadcast(Mode mode, const std::vector<byte>& message)
+{
+    Host server{Address{port}, maxRecipients};
+    setMode<compressor::Zlib>(server, mode);
+    auto connected = 0u;
+    server.onConnect([&](Peer&, uint32_t) { ++connected; });
+
+    std::atomic<bool> work{true};
+    auto clientThread = std::thread([&] {
+        Host client{maxRecipients};
+        setMode<compressor::Zlib>(client, mode);
+        for (auto i = 0u; i < maxRecipients; ++i) {
+            client.connect({"localhost", port});
+        }
+        while (work) client.service(1_ms);
+    });
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (connected < maxRecipients && Clock::now() < deadline) {
+        server.service(1_ms);
+    }
+
+    std::vector<const Peer*> peers;
+    for (auto& peer : server.getPeers()) peers.push_back(&peer);
+
+    std::vector<double> result;
+    for (auto n = 1u; n <= peers.size(); n *= 4) {
+        const auto recipients = span<const Peer* const>{
+            peers.data(), std::ptrdiff_t(n)
+        };
+        auto elapsed = 0.0;
+        for (auto i = 0u; i < broadcasts; ++i) {
+            Packet packet{message, Packet::Flag::Unreliable};
+            const auto start = Clock::now();
+            server.sendTo(recipients, std::move(packet));
+            server.flush();
+            elapsed += ns(Clock::now() - start).count();
+            server.service(); // not measured, keeps acknowledgements going
+        }
+        result.push_back(elapsed / broadcasts / 1000);
+    }
+
+    work = false;
+    clientThread.join();
+    return result;
+}
+
+int main()
+{
+    const auto data = makeMessages();
+
+    ENetPeer peer{};
+    ENetHost host{};
+    host.peers = &peer;
+    peer.host = &host;
+
+    std::cout << std::setw(24) << "Compression"
+              << std::setw(12) << "Ratio"
+              << std::setw(14) << "Per packet" << std::endl;
+
+    PacketCompression stateless;
+    stateless.setCompressor(std::make_unique<compressor::Zlib>());
+    stateless.enable(0);
+    test("stateless", data, [&](const std::vector<byte>& message) {
+        auto& packet = *enet_packet_create(message.data(), message.size(),
+                                           ENET_PACKET_FLAG_RELIABLE);
+        stateless.compress(0, packet);
+        const auto size = packet.dataLength;
+        enet_packet_destroy(&packet);
+        return size;
+    });
+
+    // window and memLevel bound the memory every peer keeps
+    const StatefulCompression::Settings settings[] = {
+        {6, 15, 8}, {6, 12, 6}, {6, 10, 4}, {1, 10, 4}
+    };
+    for (auto& setting : settings) {
+        StatefulCompression stateful{1};
+        stateful.setSettings(setting);
+        const auto memory = (1 << (setting.windowBits + 2)) +
+                            (1 << (setting.memLevel + 9)) +
+                            (1 << setting.windowBits);
+        const auto name = "stateful " + std::to_string(memory / 1024) +
+                          "KiB/peer l" + std::to_string(setting.level);
+        test(name.c_str(), data, [&](const std::vector<byte>& message) {
+            ENetPacket packet{};
+            packet.data = const_cast<byte*>(message.data());
+            packet.dataLength = message.size();
+            packet.flags = ENET_PACKET_FLAG_RELIABLE;
+            auto compressed = stateful.compress(peer, 0, packet);
+            const auto size = compressed->dataLength;
+            enet_packet_destroy(compressed);
+            return size;
+        });
+    }
+
+    // a larger message, as it would be broadcast to everyone in an area
+    std::vector<byte> message;
+    for (auto i = 0u; i < 8; ++i) {
+        message.insert(message.end(), data[i].begin(), data[i].end());
+    }
+
+    const Mode modes[] = {Mode::None, Mode::Datagram, Mode::Packet};
+    std::vector<std::vector<double>> results;
+    auto rows = size_t(-1); // fewer if not every client connected
+    for (auto mode : modes) {
+        results.push_back(testBroadcast(mode, message));
+        rows = std::min(rows, results.back().size());
+    }
+
+    std::cout << "\nBroadcast of " << message.size() << " bytes\n"
+              << std::setw(12) << "Recipients"
+              << std::setw(14) << "None"
+              << std::setw(14) << "Datagram"
+              << std::setw(14) << "Packet" << std::endl;
+    for (auto i = 0u; i < rows; ++i) {
+        std::cout << std::setw(12) << (1u << (2 * i));
+        for (auto& result : results) {
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::setw(12) << result[i] << "us";
+        }
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1239u;
+constexpr auto packets = 500u;
+constexpr auto packetSize = 4000u;
+
+using Clock = std::chrono::steady_clock;
+using seconds = std::chrono::duration<double>;
+
+// Bottleneck in front of the client, a token bucket holding 50 ms at the
+// rate, datagrams it has no tokens for are dropped
+struct Bottleneck {
+    double rate = 0; // bytes per second
+    double tokens = 0;
+    Clock::time_point refill;
+    size_t datagrams = 0;
+    size_t dropped = 0;
+} bottleneck;
+
+int ENET_CALLBACK throttle(ENetHost* host, ENetEvent*)
+{
+    const auto now = Clock::now();
+    const auto depth = bottleneck.rate / 20;
+    bottleneck.tokens = std::min(depth, bottleneck.tokens + bottleneck.rate *
+                                 seconds(now - bottleneck.refill).count());
+    bottleneck.refill = now;
+
+    bottleneck.datagrams++;
+    if (bottleneck.tokens < host->receivedDataLength) {
+        bottleneck.dropped++;
+        return 1;
+    }
+    bottleneck.tokens -= host->receivedDataLength;
+    return 0;
+}
+
+struct Result {
+    double goodput; // bytes per second
+    double dropped; // %
+    bool finished;
+};
+
+Result test(double rate, bool controlled)
+{
+    Host server{Address{port}, 1};
+    Host client{};
+    client.connect({"localhost", port}, 1);
+    server.setCongestionControl(controlled);
+
+    auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!server.getPeerCount() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    if (!server.getPeerCount()) return {0, 0, false};
+    auto& peer = server.getPeers()[0];
+
+    auto received = 0u;
+    client.onReceive([&received](Peer&, Packet&&, uint8_t) { ++received; });
+
+    bottleneck = Bottleneck{};
+    bottleneck.rate = rate;
+    bottleneck.refill = Clock::now();
+    client._onIntercept(throttle);
+
+    // whole transfer is queued at once, it is up to the sender how fast it
+    // goes out
+    const std::vector<byte> data(packetSize, 0xAA);
+    for (auto i = 0u; i < packets; ++i) peer.send({data});
+
+    const auto start = Clock::now();
+    deadline = start + std::chrono::seconds{60};
+    while (received < packets && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    const auto elapsed = seconds(Clock::now() - start).count();
+
+    return {
+        received * packetSize / elapsed,
+        100.0 * bottleneck.dropped / std::max<size_t>(bottleneck.datagrams, 1),
+        received == packets
+    };
+}
+
+void print(const Result& result)
+{
+    std::cout << std::setw(12) << std::to_string(
+                     size_t(result.goodput / 1000)) + " KB/s"
+              << std::setw(10) << result.dropped << "%"
+              << std::setw(4) << (result.finished ? "" : "(!)");
+}
+
+int main()
+{
+    std::cout << packets << " reliable packets of " << packetSize
+              << " bytes through a bottleneck, (!) did not finish in 60 s\n"
+              << std::setw(12) << "Bottleneck"
+              << std::setw(27) << "ENet throttle"
+              << std::setw(27) << "Congestion control" << std::endl;
+
+    for (auto rate : {250e3, 1e6, 4e6}) {
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(7) << size_t(rate / 1000) << " KB/s";
+        print(test(rate, false));
+        print(test(rate, true));
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,111 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1249u;
+constexpr auto packets = 500u;
+constexpr auto packetSize = 8000u;
+constexpr auto interval = std::chrono::milliseconds{4};
+constexpr auto drain = std::chrono::milliseconds{300};
+
+using Clock = std::chrono::steady_clock;
+
+// Datagrams arriving at the client are dropped at random
+double lossRate = 0;
+std::mt19937 generator{42};
+
+int ENET_CALLBACK dropDatagram(ENetHost*, ENetEvent*)
+{
+    return std::uniform_real_distribution<>{}(generator) < lossRate;
+}
+
+struct Result {
+    double delivered; // %
+    double latency; // median, ms
+};
+
+Result test(double loss, bool corrected)
+{
+    Host server{Address{port}, 1};
+    Host client{};
+    client.connect({"localhost", port}, 2);
+    if (corrected) {
+        server.enableErrorCorrection(1);
+        client.enableErrorCorrection(1);
+    }
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!server.getPeerCount() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    auto& peer = server.getPeers()[0];
+
+    std::vector<double> latencies;
+    client.onReceive([&](Peer&, Packet&& packet, uint8_t channelId) {
+        if (channelId != 1) return;
+
+        Clock::rep sent;
+        std::memcpy(&sent, packet.getData().data(), sizeof(sent));
+        const auto start = Clock::time_point{Clock::duration{sent}};
+        using ms = std::chrono::duration<double, std::milli>;
+        latencies.push_back(ms(Clock::now() - start).count());
+    });
+
+    lossRate = loss;
+    client._onIntercept(dropDatagram);
+
+    std::vector<byte> data(packetSize, 0xAA);
+    auto next = Clock::now();
+    for (auto sent = 0u; sent < packets;) {
+        if (Clock::now() >= next) {
+            const auto now = Clock::now().time_since_epoch().count();
+            std::memcpy(data.data(), &now, sizeof(now));
+            peer.send(Packet{data, Packet::Flag::Fragment}, 1);
+            next += interval;
+            sent++;
+        }
+        server.service();
+        client.service();
+    }
+    for (const auto end = Clock::now() + drain; Clock::now() < end;) {
+        server.service();
+        client.service(1_ms);
+    }
+
+    if (latencies.empty()) return {0, 0};
+    const auto median = latencies.begin() + latencies.size() / 2;
+    std::nth_element(latencies.begin(), median, latencies.end());
+    return {100.0 * latencies.size() / packets, *median};
+}
+
+int main()
+{
+    std::cout << packets << " unreliable packets of " << packetSize
+              << " bytes\n"
+              << std::setw(8) << "Loss"
+              << std::setw(28) << "Fragments"
+              << std::setw(28) << "Error correction" << std::endl;
+
+    for (auto loss : {0.0, 0.01, 0.02, 0.05, 0.1}) {
+        const auto plain = test(loss, false);
+        const auto corrected = test(loss, true);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(7) << loss * 100 << "%"
+                  << std::setw(12) << plain.delivered << "% in "
+                  << std::setw(8) << plain.latency << "ms"
+                  << std::setw(12) << corrected.delivered << "% in "
+                  << std::setw(8) << corrected.latency << "ms" << std::endl;
+    }
+}
@@ -0,0 +1,135 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <array>
+#include <random>
+#include <functional>
+#include <unordered_map>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto messages = 10000000u;
+constexpr auto types = 16u;
+
+using Clock = std::chrono::steady_clock;
+using ns = std::chrono::duration<double, std::nano>;
+
+std::array<size_t, types> counts{};
+
+template <uint8_t Id>
+void handle(Peer&, Packet&& packet)
+{
+    counts[Id] += packet.getSize();
+}
+
+template <uint8_t Id>
+void handleRaw(void*, Peer& peer, Packet&& packet)
+{
+    handle<Id>(peer, std::move(packet));
+}
+
+template <size_t... Ids>
+std::array<Router::Handler, types> makeHandlers(std::index_sequence<Ids...>)
+{
+    return {{handleRaw<Ids>...}};
+}
+
+template <size_t... Ids>
+StaticRouter<Route<0, Ids, handle<Ids>>...> makeStatic(
+    std::index_sequence<Ids...>);
+
+using Routes = decltype(makeStatic(std::make_index_sequence<types>{}));
+
+template <typename Dispatch>
+void test(const char* name, std::vector<ENetPacket>& packets,
+          Dispatch dispatch)
+{
+    counts = {};
+    const auto start = Clock::now();
+    for (auto i = 0u; i < messages; ++i) {
+        Packet packet{packets[i % packets.size()], false};
+        dispatch(packet);
+    }
+    const auto elapsed = ns(Clock::now() - start).count();
+
+    auto total = size_t(0);
+    for (auto count : counts) total += count;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(16) << name
+              << std::setw(10) << elapsed / messages << "ns"
+              << std::setw(12) << total << std::endl;
+}
+
+int main()
+{
+    Host host;
+    Peer peer{host};
+
+    std::mt19937 random{42};
+    std::vector<std::array<byte, 8>> data(4096);
+    std::vector<ENetPacket> packets(data.size());
+    for (auto i = 0u; i < data.size(); ++i) {
+        data[i] = {{byte(random() % types)}};
+        packets[i].data = data[i].data();
+        packets[i].dataLength = data[i].size();
+    }
+
+    std::cout << std::setw(16) << "Dispatch"
+              << std::setw(12) << "Time"
+              << std::setw(12) << "Check" << std::endl;
+
+    // what onReceive callbacks do today
+    Host::Callback callback = [](Peer& peer, Packet&& packet, uint8_t) {
+        switch (packet.getData()[0]) {
+        case 0: handle<0>(peer, std::move(packet)); break;
+        case 1: handle<1>(peer, std::move(packet)); break;
+        case 2: handle<2>(peer, std::move(packet)); break;
+        case 3: handle<3>(peer, std::move(packet)); break;
+        case 4: handle<4>(peer, std::move(packet)); break;
+        case 5: handle<5>(peer, std::move(packet)); break;
+        case 6: handle<6>(peer, std::move(packet)); break;
+        case 7: handle<7>(peer, std::move(packet)); break;
+        case 8: handle<8>(peer, std::move(packet)); break;
+        case 9: handle<9>(peer, std::move(packet)); break;
+        case 10: handle<10>(peer, std::move(packet)); break;
+        case 11: handle<11>(peer, std::move(packet)); break;
+        case 12: handle<12>(peer, std::move(packet)); break;
+        case 13: handle<13>(peer, std::move(packet)); break;
+        case 14: handle<14>(peer, std::move(packet)); break;
+        case 15: handle<15>(peer, std::move(packet)); break;
+        }
+    };
+    test("switch", packets, [&](Packet& packet) {
+        callback(peer, std::move(packet), 0);
+    });
+
+    using Function = std::function<void (Peer&, Packet&&)>;
+    std::unordered_map<uint16_t, Function> map;
+    Router router;
+    const auto handlers = makeHandlers(std::make_index_sequence<types>{});
+    for (auto id = 0u; id < types; ++id) {
+        const auto handler = handlers[id];
+        map[id] = [handler](Peer& peer, Packet&& packet) {
+            handler(nullptr, peer, std::move(packet));
+        };
+        router.add(0, id, handler);
+    }
+
+    test("unordered_map", packets, [&](Packet& packet) {
+        const auto key = uint16_t(packet.getData()[0]); // channel 0
+        map.find(key)->second(peer, std::move(packet));
+    });
+
+    test("Router", packets, [&](Packet& packet) {
+        router.dispatch(peer, packet, 0);
+    });
+
+    test("StaticRouter", packets, [&](Packet& packet) {
+        Routes::dispatch(peer, packet, 0);
+    });
+}
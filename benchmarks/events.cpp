@@ -0,0 +1,142 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1245u;
+constexpr auto rounds = 20000u;
+constexpr auto batch = 64u;
+constexpr auto calls = 50000000u;
+
+using Clock = std::chrono::steady_clock;
+using ns = std::chrono::duration<double, std::nano>;
+
+struct Handler {
+    size_t connected = 0;
+    size_t received = 0;
+    size_t bytes = 0;
+
+    void onConnect(Peer&, uint32_t) { ++connected; }
+    void onReceive(Peer&, Packet&& packet, uint8_t)
+    {
+        ++received;
+        bytes += packet.getSize();
+    }
+    void onDisconnect(size_t, uint32_t) { --connected; }
+};
+
+template <typename Server>
+void test(const char* name, Server& server, const Handler& handler)
+{
+    Host client;
+    auto& peer = client.connect({"localhost", port});
+    while (!handler.connected) {
+        client.service();
+        server.service(1_ms);
+    }
+    client.service();
+
+    const std::vector<byte> payload(16);
+    auto elapsed = 0.0;
+    for (auto i = 0u; i < rounds; ++i) {
+        for (auto j = 0u; j < batch; ++j) {
+            peer.send(Packet{payload, Packet::Flag::Unreliable});
+        }
+        client.flush();
+
+        // only the server side is measured, it sees the same datagrams
+        const auto expected = handler.received + batch;
+        const auto start = Clock::now();
+        while (handler.received < expected) server.service(1_ms);
+        elapsed += ns(Clock::now() - start).count();
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(20) << name
+              << std::setw(12) << elapsed / rounds / batch << "ns"
+              << std::setw(12) << handler.bytes << std::endl;
+
+    peer.disconnect();
+    while (handler.connected) {
+        client.service();
+        server.service(1_ms);
+    }
+}
+
+template <typename Deliver>
+void delivery(const char* name, std::vector<ENetPacket>& packets,
+              Peer& peer, const Handler& handler, Deliver deliver)
+{
+    const auto start = Clock::now();
+    for (auto i = 0u; i < calls; ++i) {
+        deliver(peer, Packet{packets[i % packets.size()], false}, 0);
+    }
+    const auto elapsed = ns(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(20) << name
+              << std::setw(12) << elapsed / calls << "ns"
+              << std::setw(12) << handler.bytes << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setw(20) << "Event loop"
+              << std::setw(14) << "Per event"
+              << std::setw(12) << "Check" << std::endl;
+
+    {
+        Handler handler;
+        Host server{Address{port}, 1};
+        server.onConnect([&](Peer& peer, uint32_t data) {
+            handler.onConnect(peer, data);
+        });
+        server.onReceive([&](Peer& peer, Packet&& packet, uint8_t channelId) {
+            handler.onReceive(peer, std::move(packet), channelId);
+        });
+        server.onDisconnect([&](size_t id, uint32_t data) {
+            handler.onDisconnect(id, data);
+        });
+        test("Host", server, handler);
+    }
+
+    {
+        StaticHost<Handler> server{Address{port}, 1};
+        test("StaticHost", server, server.getHandler());
+    }
+
+    // the delivery step alone, without ENet and the socket around it
+    std::cout << std::setw(20) << "Delivery"
+              << std::setw(14) << "Per event"
+              << std::setw(12) << "Check" << std::endl;
+
+    Host host;
+    Peer peer{host};
+    std::vector<byte> data(256);
+    std::vector<ENetPacket> packets(data.size());
+    for (auto i = 0u; i < packets.size(); ++i) {
+        packets[i].data = data.data();
+        packets[i].dataLength = i + 1;
+    }
+
+    Handler handler;
+    const Host::Callback callback = [&](Peer& peer, Packet&& packet,
+                                        uint8_t channelId) {
+        handler.onReceive(peer, std::move(packet), channelId);
+    };
+    delivery("Convw", packets, peer, handler, [&](Peer& peer, Packet&& packet,
+                                                  uint8_t channelId) {
+        callback(peer, std::move(packet), channelId);
+    });
+
+    handler = Handler{};
+    delivery("Direct", packets, peer, handler, [&](Peer& peer, Packet&& packet,
+                                                   uint8_t channelId) {
+        handler.onReceive(peer, std::move(packet), channelId);
+    });
+}
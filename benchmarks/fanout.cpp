@@ -0,0 +1,95 @@
+#include "wenet/wenet.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1244u;
+constexpr auto clients = 256u;
+constexpr auto rounds = 2000u;
+
+using Clock = std::chrono::steady_clock;
+using ns = std::chrono::duration<double, std::nano>;
+
+template <typename Send>
+void test(const char* name, Host& server, Send send)
+{
+    const std::vector<byte> payload(64);
+
+    auto elapsed = 0.0;
+    auto sent = size_t(0);
+    for (auto i = 0u; i < rounds; ++i) {
+        const auto start = Clock::now();
+        sent += send(Packet{payload, Packet::Flag::Unreliable});
+        elapsed += ns(Clock::now() - start).count();
+        server.flush(); // not measured, keeps queues from growing
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(20) << name
+              << std::setw(12) << elapsed / rounds / 1000 << "us"
+              << std::setw(12) << elapsed / sent << "ns"
+              << std::endl;
+}
+
+int main()
+{
+    Host server{Address{port}, clients};
+    auto connected = 0u;
+    server.onConnect([&](Peer&, uint32_t) { ++connected; });
+
+    std::atomic<bool> work{true};
+    auto clientThread = std::thread([&] {
+        Host client{clients};
+        for (auto i = 0u; i < clients; ++i) client.connect({"localhost", port});
+        while (work) client.service(1_ms);
+    });
+    while (connected < clients) server.service(1_ms);
+
+    auto peers = server.getPeers();
+    const auto& sender = peers[0];
+    std::vector<const Peer*> half;
+    for (auto i = 0u; i < clients; i += 2) half.push_back(&peers[i]);
+
+    std::cout << std::setw(20) << "Fan-out"
+              << std::setw(14) << "Per send"
+              << std::setw(14) << "Per peer"
+              << std::endl;
+
+    test("Peer::send loop", server, [&](Packet&& packet) {
+        auto sent = size_t(0);
+        for (auto& peer : server.getPeers()) {
+            if (&peer != &sender) sent += peer.send(packet);
+        }
+        return sent;
+    });
+
+    test("broadcastExcept", server, [&](Packet&& packet) {
+        return server.broadcastExcept(sender, std::move(packet));
+    });
+
+    test("broadcastIf", server, [&](Packet&& packet) {
+        return server.broadcastIf([&](const Peer& peer) {
+            return &peer != &sender;
+        }, std::move(packet));
+    });
+
+    test("Peer::send half", server, [&](Packet&& packet) {
+        auto sent = size_t(0);
+        for (auto peer : half) sent += peer->send(packet);
+        return sent;
+    });
+
+    test("sendTo half", server, [&](Packet&& packet) {
+        return server.sendTo(half, std::move(packet));
+    });
+
+    work = false;
+    clientThread.join();
+}
@@ -0,0 +1,275 @@
+#include "wenet/wenet.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <memory>
+
+using namespace sq;
+using namespace sq::wenet;
+
+// Simulated clients are peers of a few client hosts, one per thread, so
+// thousands of them do not need thousands of threads. ENet caps a host at
+// 4095 peers, bigger runs get more client threads and server shards
+constexpr auto basePort = 1247u;
+constexpr auto maxPeers = 4095u;
+constexpr auto drain = std::chrono::milliseconds{500};
+constexpr auto connectTimeout = std::chrono::seconds{30};
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+    size_t clients = 1000;
+    size_t threads = 4;
+    double rate = 20; // messages per second per client
+    size_t size = 64; // bytes per message
+    double seconds = 10;
+    speed::bs pacing = 0; // bytes per second from each server, 0 is off
+};
+
+// Echoes everything back, counts what it got
+struct Server {
+    Host host;
+    std::atomic<size_t> messages{0};
+    std::atomic<size_t> bytes{0};
+
+    Server(uint16_t port, size_t peers, speed::bs pacing)
+        : host(Address{port}, peers)
+    {
+        if (pacing) host.setPacing({0, pacing, time::us{2000}});
+        host.onReceive([this](Peer& peer, Packet&& packet, uint8_t) {
+            messages.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(packet.getSize(), std::memory_order_relaxed);
+            peer.send(std::move(packet));
+        });
+    }
+};
+
+// Per client results of one thread
+struct Results {
+    std::vector<size_t> sent;
+    std::vector<size_t> received;
+    std::vector<float> latencies; // us
+};
+
+struct Stamp {
+    int64_t time;
+    uint32_t client;
+};
+
+void runClients(const Settings& settings, size_t first, size_t count,
+                size_t servers, std::atomic<size_t>& connected,
+                const std::atomic<bool>& ready, const Clock::time_point& start,
+                Results& results)
+{
+    Host host{count};
+    std::vector<Peer*> peers(count);
+    for (auto i = size_t(0); i < count; ++i) {
+        const auto port = uint16_t(basePort + (first + i) % servers);
+        peers[i] = &host.connect({"localhost", port});
+    }
+
+    results.sent.assign(count, 0);
+    results.received.assign(count, 0);
+    host.onConnect([&](Peer&, uint32_t) { ++connected; });
+    host.onReceive([&](Peer&, Packet&& packet, uint8_t) {
+        if (!ready || packet.getSize() < sizeof(Stamp)) return;
+
+        Stamp stamp;
+        std::memcpy(&stamp, packet.getData().data(), sizeof(stamp));
+        const auto sent = Clock::time_point{Clock::duration{stamp.time}};
+        using us = std::chrono::duration<float, std::micro>;
+        results.latencies.push_back(us(Clock::now() - sent).count());
+        results.received[stamp.client]++;
+    });
+
+    while (!ready) host.service(1_ms);
+
+    // clients are spread evenly over the send interval
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{1 / settings.rate}
+    );
+    std::vector<Clock::time_point> next(count);
+    for (auto i = size_t(0); i < count; ++i) {
+        next[i] = start + interval * (first + i) / settings.clients;
+    }
+
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{settings.seconds}
+    );
+    std::vector<byte> data(std::max(settings.size, sizeof(Stamp)));
+    for (auto now = Clock::now(); now < end + drain; now = Clock::now()) {
+        for (auto i = size_t(0); i < count && now < end; ++i) {
+            if (next[i] > now) continue;
+
+            const Stamp stamp{now.time_since_epoch().count(), uint32_t(i)};
+            std::memcpy(data.data(), &stamp, sizeof(stamp));
+            peers[i]->send(Packet{data, Packet::Flag::Unreliable});
+            results.sent[i]++;
+            next[i] += interval;
+        }
+        host.service(1_ms);
+    }
+
+    for (auto peer : peers) peer->disconnectNow();
+}
+
+float getPercentile(std::vector<float>& values, double percentile)
+{
+    if (values.empty()) return 0;
+    const auto index = size_t((values.size() - 1) * percentile);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    if (argc > 1) settings.clients = std::stoul(argv[1]);
+    if (argc > 2) settings.threads = std::stoul(argv[2]);
+    if (argc > 3) settings.rate = std::stod(argv[3]);
+    if (argc > 4) settings.size = std::stoul(argv[4]);
+    if (argc > 5) settings.seconds = std::stod(argv[5]);
+    if (argc > 6) settings.pacing = std::stoul(argv[6]);
+
+    const auto shards = (settings.clients + maxPeers - 1) / maxPeers;
+    const auto threads = std::max(settings.threads, shards);
+
+    std::cout << "Usage: " << argv[0]
+              << " [clients] [threads] [rate] [size] [seconds] [pacing]\n"
+              << settings.clients << " clients on " << threads
+              << " threads, " << shards << " server shards, "
+              << settings.rate << " messages/s of " << settings.size
+              << " bytes each for " << settings.seconds << "s" << std::endl;
+
+    std::atomic<bool> work{true};
+    std::vector<std::unique_ptr<Server>> servers;
+    std::vector<std::thread> serverThreads;
+    for (auto i = size_t(0); i < shards; ++i) {
+        const auto peers = (settings.clients + shards - 1) / shards;
+        servers.emplace_back(
+            new Server{uint16_t(basePort + i), peers, settings.pacing}
+        );
+        const auto server = servers.back().get();
+        serverThreads.emplace_back([&work, server] {
+            while (work) server->host.service(1_ms);
+        });
+    }
+
+    std::atomic<size_t> connected{0};
+    std::atomic<bool> ready{false};
+    Clock::time_point start;
+    std::vector<Results> results(threads);
+    std::vector<std::thread> clientThreads;
+    for (auto i = size_t(0); i < threads; ++i) {
+        const auto first = settings.clients * i / threads;
+        const auto count = settings.clients * (i + 1) / threads - first;
+        clientThreads.emplace_back([&, i, first, count] {
+            runClients(settings, first, count, shards, connected, ready,
+                       start, results[i]);
+        });
+    }
+
+    const auto connecting = Clock::now();
+    while (connected < settings.clients &&
+           Clock::now() - connecting < connectTimeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    using seconds = std::chrono::duration<double>;
+    if (connected < settings.clients) {
+        std::cout << "Only " << connected << " of " << settings.clients
+                  << " clients connected in " << connectTimeout.count()
+                  << "s" << std::endl;
+
+        // clients see no time left to send, drain and disconnect
+        settings.seconds = 0;
+        start = Clock::now();
+        ready = true;
+        for (auto& thread : clientThreads) thread.join();
+        work = false;
+        for (auto& thread : serverThreads) thread.join();
+        return 1;
+    }
+    std::cout << "Connected " << connected << " clients in "
+              << seconds(Clock::now() - connecting).count() << "s"
+              << std::endl;
+
+    const auto count = [&] {
+        auto messages = size_t(0), bytes = size_t(0);
+        for (auto& server : servers) {
+            messages += server->messages;
+            bytes += server->bytes;
+        }
+        return std::make_pair(messages, bytes);
+    };
+
+    start = Clock::now() + std::chrono::milliseconds{100};
+    ready = true;
+    std::this_thread::sleep_until(start);
+    const auto before = count();
+    std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<Clock::duration>(
+            seconds{settings.seconds}
+        )
+    );
+    const auto after = count();
+
+    for (auto& thread : clientThreads) thread.join();
+    work = false;
+    for (auto& thread : serverThreads) thread.join();
+
+    std::vector<float> latencies;
+    auto sent = size_t(0), received = size_t(0);
+    auto sum = 0.0, squares = 0.0;
+    auto least = ~size_t(0), most = size_t(0);
+    for (auto& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(),
+                         result.latencies.end());
+        for (auto i = size_t(0); i < result.sent.size(); ++i) {
+            const auto echoed = result.received[i];
+            sent += result.sent[i];
+            received += echoed;
+            sum += echoed;
+            squares += double(echoed) * echoed;
+            least = std::min(least, echoed);
+            most = std::max(most, echoed);
+        }
+    }
+
+    // Jain's index, 1 when every client got the same share
+    const auto fairness = squares ? sum * sum / (settings.clients * squares)
+                                  : 0;
+    const auto loss = sent ? 100.0 * (sent - received) / sent : 0;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(12) << "Server"
+              << std::setw(12) << (after.first - before.first) /
+                                  settings.seconds << " msg/s"
+              << std::setw(12) << (after.second - before.second) /
+                                  settings.seconds / 1024 << " KiB/s\n"
+              << std::setw(12) << "Latency"
+              << std::setw(12) << getPercentile(latencies, 0.5) << " us p50"
+              << std::setw(12) << getPercentile(latencies, 0.99) << " us p99"
+              << std::setw(12) << getPercentile(latencies, 1) << " us max\n"
+              << std::setw(12) << "Loss"
+              << std::setw(12) << loss << " %\n"
+              << std::setprecision(3)
+              << std::setw(12) << "Fairness"
+              << std::setw(12) << fairness << " Jain"
+              << std::setw(12) << least << " min"
+              << std::setw(12) << most << " max per client" << std::endl;
+
+    if (settings.pacing) {
+        const auto gaps = servers.front()->host.getPacingGaps();
+        std::cout << std::setw(12) << "Pacing"
+                  << std::setw(12) << gaps.average.count() << " us gap"
+                  << std::setw(12) << gaps.last.count() << " us last"
+                  << std::endl;
+    }
+}
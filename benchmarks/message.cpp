@@ -0,0 +1,166 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto messages = 1000000u;
+
+struct PlayerState {
+    uint32_t id;
+    float x;
+    float y;
+    float z;
+    float yaw;
+    uint8_t health;
+    bool crouching;
+    message::Optional<uint32_t> target;
+};
+
+namespace bitpacked {
+
+using namespace message;
+
+using Schema = message::Schema<PlayerState,
+    WENET_FIELD(&PlayerState::id, Int<0, 4095>),
+    WENET_FIELD(&PlayerState::x, Float<-1024, 1024, 18>),
+    WENET_FIELD(&PlayerState::y, Float<-1024, 1024, 18>),
+    WENET_FIELD(&PlayerState::z, Float<-64, 64, 12>),
+    WENET_FIELD(&PlayerState::yaw, Float<0, 360, 10>),
+    WENET_FIELD(&PlayerState::health, Int<0, 100>),
+    WENET_FIELD(&PlayerState::crouching, Bool),
+    WENET_FIELD(&PlayerState::target, Opt<Int<0, 4095>>)
+>;
+
+Packet encode(const PlayerState& state)
+{
+    return Schema::pack(state, Packet::Flag::Unreliable);
+}
+
+bool decode(const Packet& packet, PlayerState& state)
+{
+    return Schema::unpack(packet, state);
+}
+
+} // \bitpacked
+
+// What the examples do, every field at its full width through a vector
+namespace naive {
+
+template <typename T>
+void put(std::vector<byte>& data, const T& value)
+{
+    const auto bytes = reinterpret_cast<const byte*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+void get(span<const byte> data, size_t& offset, T& value)
+{
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    offset += sizeof(value);
+}
+
+Packet encode(const PlayerState& state)
+{
+    std::vector<byte> data;
+    put(data, state.id);
+    put(data, state.x);
+    put(data, state.y);
+    put(data, state.z);
+    put(data, state.yaw);
+    put(data, state.health);
+    put(data, state.crouching);
+    put(data, state.target.set);
+    if (state.target) put(data, *state.target);
+    return {data, Packet::Flag::Unreliable};
+}
+
+bool decode(const Packet& packet, PlayerState& state)
+{
+    const auto data = span<const byte>{packet.getData()};
+    auto offset = size_t(0);
+    get(data, offset, state.id);
+    get(data, offset, state.x);
+    get(data, offset, state.y);
+    get(data, offset, state.z);
+    get(data, offset, state.yaw);
+    get(data, offset, state.health);
+    get(data, offset, state.crouching);
+    get(data, offset, state.target.set);
+    if (state.target) get(data, offset, *state.target);
+    return true;
+}
+
+} // \naive
+
+std::vector<PlayerState> generate()
+{
+    std::mt19937 random{42};
+    std::uniform_real_distribution<float> position{-1000, 1000};
+    std::uniform_real_distribution<float> height{-60, 60};
+    std::uniform_real_distribution<float> angle{0, 360};
+
+    std::vector<PlayerState> states(1024);
+    for (auto& state : states) {
+        state.id = random() % 4096;
+        state.x = position(random);
+        state.y = position(random);
+        state.z = height(random);
+        state.yaw = angle(random);
+        state.health = random() % 101;
+        state.crouching = random() % 2;
+        if (random() % 4 == 0) state.target = uint32_t(random() % 4096);
+    }
+    return states;
+}
+
+template <typename Encode, typename Decode>
+void test(const char* name, const std::vector<PlayerState>& states,
+          Encode encode, Decode decode)
+{
+    using Clock = std::chrono::steady_clock;
+    using ns = std::chrono::duration<double, std::nano>;
+
+    auto bytes = size_t(0);
+    auto valid = size_t(0);
+    PlayerState state{};
+
+    const auto start = Clock::now();
+    for (auto i = 0u; i < messages; ++i) {
+        auto packet = encode(states[i % states.size()]);
+        bytes += packet.getSize();
+        valid += decode(packet, state);
+    }
+    const auto elapsed = ns(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(12) << name
+              << std::setw(12) << double(bytes) / messages << "B"
+              << std::setw(12) << elapsed / messages << "ns"
+              << std::setw(10) << valid << std::endl;
+}
+
+int main()
+{
+    enet_initialize();
+
+    const auto states = generate();
+
+    std::cout << std::setw(12) << "Encoding"
+              << std::setw(13) << "Size"
+              << std::setw(14) << "Time"
+              << std::setw(10) << "Valid"
+              << std::endl;
+
+    test("naive", states, naive::encode, naive::decode);
+    test("bitpacked", states, bitpacked::encode, bitpacked::decode);
+
+    enet_deinitialize();
+}
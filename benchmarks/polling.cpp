@@ -0,0 +1,125 @@
+#include "wenet/wenet.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <algorithm>
+
+#include <time.h>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1242u;
+constexpr auto pings = 1000u;
+
+using Clock = std::chrono::steady_clock;
+using us = std::chrono::duration<double, std::micro>;
+
+enum class Mode { Hot, Block, Poll };
+
+struct Result {
+    double median; // us
+    double tail; // 99th percentile, us
+    double cpu; // server core usage, %
+};
+
+double threadTime()
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+bool wait(Host& host, Mode mode)
+{
+    switch (mode) {
+    case Mode::Hot: return host.service();
+    case Mode::Block: return host.service(1_ms);
+    case Mode::Poll: return host.poll(1_ms);
+    }
+    return false;
+}
+
+Result test(Mode mode, std::chrono::microseconds gap)
+{
+    const Host::Polling polling{200_us, true};
+
+    Host server{Address{port}, 1};
+    server.setPolling(polling);
+    server.onReceive([](Peer& peer, Packet&& packet, uint8_t) {
+        peer.send(std::move(packet));
+    });
+
+    std::atomic<bool> work{true};
+    auto cpu = 0.0;
+    auto serverThread = std::thread([&] {
+        const auto start = threadTime();
+        while (work) wait(server, mode);
+        cpu = threadTime() - start;
+    });
+
+    Host client;
+    client.setPolling(polling);
+    Peer peer{client};
+    peer = *client.connect({"localhost", port});
+
+    auto connected = false;
+    auto received = false;
+    client.onConnect([&](Peer&, uint32_t) { connected = true; });
+    client.onReceive([&](Peer&, Packet&&, uint8_t) { received = true; });
+    while (!connected) client.service(1_ms);
+
+    const std::vector<byte> payload(32);
+    std::vector<double> latencies;
+
+    const auto start = Clock::now();
+    for (auto i = 0u; i < pings; ++i) {
+        const auto sent = Clock::now();
+        peer.send(Packet{payload});
+
+        received = false;
+        while (!received) wait(client, mode);
+        latencies.push_back(us(Clock::now() - sent).count());
+
+        std::this_thread::sleep_until(sent + gap);
+    }
+    const auto elapsed = us(Clock::now() - start).count();
+
+    work = false;
+    serverThread.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    return {latencies[pings / 2], latencies[pings * 99 / 100],
+            cpu / elapsed * 100};
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    const char* names[] = {"service(0)", "service(1ms)", "poll(1ms)"};
+
+    std::cout << std::setw(14) << "Mode"
+              << std::setw(12) << "Gap"
+              << std::setw(12) << "Median"
+              << std::setw(12) << "99%"
+              << std::setw(12) << "Server CPU"
+              << std::endl;
+
+    for (auto gap : {50us, 500us, 5000us}) {
+        for (auto mode : {Mode::Hot, Mode::Block, Mode::Poll}) {
+            const auto result = test(mode, gap);
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::setw(14) << names[int(mode)]
+                      << std::setw(10) << gap.count() << "us"
+                      << std::setw(10) << result.median << "us"
+                      << std::setw(10) << result.tail << "us"
+                      << std::setw(11) << result.cpu << "%"
+                      << std::endl;
+        }
+    }
+}
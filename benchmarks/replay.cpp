@@ -0,0 +1,85 @@
+#include "wenet/wenet.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+
+using namespace sq;
+using namespace sq::wenet;
+
+// Usage: benchmark_replay [capture [peers]]
+// Without a capture one is recorded first from a few local clients
+
+constexpr auto port = 1243u;
+constexpr auto clients = 4u;
+constexpr auto packets = 2000u;
+constexpr auto captureSize = 64u << 20;
+
+void record(const std::string& path, size_t peers)
+{
+    Host server{Address{port}, peers};
+    server.startCapture(path, captureSize);
+
+    std::atomic<bool> work{true};
+    auto serverThread = std::thread([&] {
+        while (work) server.service(1_ms);
+    });
+
+    Host client{clients};
+    auto connected = 0u;
+    client.onConnect([&](Peer&, uint32_t) { ++connected; });
+    for (auto i = 0u; i < clients; ++i) client.connect({"localhost", port});
+    while (connected < clients) client.service(1_ms);
+
+    const std::vector<byte> payload(64);
+    for (auto i = 0u; i < packets; ++i) {
+        for (auto& peer : client.getPeers()) peer.send(Packet{payload});
+        client.service();
+    }
+    for (auto& peer : client.getPeers()) peer.disconnect();
+    while (client.service(10_ms)) { }
+
+    work = false;
+    serverThread.join();
+}
+
+void replay(const std::string& path, size_t peers, bool realtime)
+{
+    Host server{Address{port}, peers};
+    auto received = 0u;
+    server.onReceive([&](Peer&, Packet&&, uint8_t) { ++received; });
+
+    Replay replay{path};
+    const auto stats = replay.run(server, realtime);
+
+    using seconds = std::chrono::duration<double>;
+    const auto elapsed = seconds(stats.elapsed).count();
+    std::cout << std::fixed << std::setprecision(1)
+              << std::setw(10) << (realtime ? "realtime" : "fast")
+              << std::setw(12) << stats.datagrams
+              << std::setw(12) << received
+              << std::setw(12) << elapsed * 1e3 << "ms"
+              << std::setw(14) << stats.datagrams / elapsed << "/s"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string path = argc > 1 ? argv[1] : "replay.wcap";
+    const auto peers = argc > 2 ? std::stoul(argv[2]) : clients;
+    if (argc < 2) record(path, peers);
+
+    std::cout << std::setw(10) << "Mode"
+              << std::setw(12) << "Datagrams"
+              << std::setw(12) << "Packets"
+              << std::setw(14) << "Elapsed"
+              << std::setw(16) << "Rate"
+              << std::endl;
+
+    replay(path, peers, true);
+    replay(path, peers, false);
+}
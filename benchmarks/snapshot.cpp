@@ -0,0 +1,92 @@
+#include "wenet/wenet.hpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <random>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto port = 1245u;
+constexpr auto clients = 2000u;
+constexpr auto entities = 4000u;
+constexpr auto ticks = 50u;
+
+using Clock = std::chrono::steady_clock;
+using ms = std::chrono::duration<double, std::milli>;
+
+struct Entity {
+    float x;
+    float y;
+    uint32_t id;
+};
+
+// Personalised snapshot, everything within view distance of the peer
+Packet build(const std::vector<Entity>& world, const Entity& viewer)
+{
+    std::vector<byte> data;
+    for (auto& entity : world) {
+        const auto dx = entity.x - viewer.x;
+        const auto dy = entity.y - viewer.y;
+        if (dx * dx + dy * dy > 100 * 100) continue;
+
+        const auto bytes = reinterpret_cast<const byte*>(&entity);
+        data.insert(data.end(), bytes, bytes + sizeof(entity));
+    }
+    return {data, Packet::Flag::Unreliable};
+}
+
+int main()
+{
+    Host server{Address{port}, clients};
+    auto connected = 0u;
+    server.onConnect([&](Peer&, uint32_t) { ++connected; });
+
+    std::atomic<bool> work{true};
+    auto clientThread = std::thread([&] {
+        Host client{clients};
+        for (auto i = 0u; i < clients; ++i) client.connect({"localhost", port});
+        while (work) client.service(1_ms);
+    });
+    while (connected < clients) server.service(1_ms);
+
+    std::mt19937 random{42};
+    std::uniform_real_distribution<float> position{0, 1000};
+    std::vector<Entity> world(entities);
+    for (auto i = 0u; i < entities; ++i) {
+        world[i] = {position(random), position(random), i};
+    }
+
+    std::cout << std::setw(10) << "Threads"
+              << std::setw(12) << "Tick"
+              << std::setw(12) << "Sent" << std::endl;
+
+    const auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (auto threads = 0u; threads < cores; threads = threads * 2 + 1) {
+        server.setWorkThreads(threads);
+
+        auto sent = size_t(0);
+        auto elapsed = 0.0;
+        for (auto tick = 0u; tick < ticks; ++tick) {
+            const auto start = Clock::now();
+            sent += server.sendEach([&](const Peer& peer) {
+                const auto index = peer.getId() % entities;
+                return build(world, world[index]);
+            });
+            elapsed += ms(Clock::now() - start).count();
+            server.flush();
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << threads + 1
+                  << std::setw(10) << elapsed / ticks << "ms"
+                  << std::setw(12) << sent / ticks << std::endl;
+    }
+
+    work = false;
+    clientThread.join();
+}
@@ -0,0 +1,90 @@
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+using namespace sq;
+using namespace sq::wenet;
+
+constexpr auto peerCount = 4096u;
+constexpr auto scans = 10000u;
+constexpr auto threshold = 200u; // ms
+
+using Clock = std::chrono::steady_clock;
+using us = std::chrono::duration<double, std::micro>;
+
+template <typename Scan>
+void test(const char* name, Scan scan)
+{
+    auto found = size_t(0);
+    const auto start = Clock::now();
+    for (auto i = 0u; i < scans; ++i) found += scan();
+    const auto elapsed = us(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(16) << name
+              << std::setw(10) << elapsed / scans << "us"
+              << std::setw(10) << found / scans << std::endl;
+}
+
+int main()
+{
+    Host host;
+
+    // peers of a host that is not serving them, the fields scanned are all
+    // that matters
+    std::vector<ENetPeer> enetPeers(peerCount);
+    ENetHost enetHost{};
+    enetHost.peers = enetPeers.data();
+    enetHost.peerCount = enetPeers.size();
+
+    std::mt19937 random{42};
+    std::vector<Peer> peers;
+    PeerTable table{peerCount};
+    for (auto i = 0u; i < peerCount; ++i) {
+        auto& peer = enetPeers[i];
+        peer.state = random() % 8 ? ENET_PEER_STATE_CONNECTED
+                                  : ENET_PEER_STATE_DISCONNECTED;
+        peer.roundTripTime = random() % 300;
+        peer.packetLoss = random() % ENET_PEER_PACKET_LOSS_SCALE;
+
+        peers.emplace_back(host, peer);
+        table.setManaged(i, true);
+    }
+
+    std::cout << std::setw(16) << "Scan"
+              << std::setw(12) << "Time"
+              << std::setw(10) << "Found" << std::endl;
+
+    std::vector<Peer*> slow;
+    slow.reserve(peerCount);
+    test("Peer getters", [&] {
+        slow.clear();
+        for (auto& peer : peers) {
+            if (peer.getState() == Peer::State::Connected &&
+                peer.getRoundTripTime() > time::ms{threshold}) {
+                slow.push_back(&peer);
+            }
+        }
+        return slow.size();
+    });
+
+    test("table refresh", [&] {
+        table.refresh(enetHost);
+        return size_t(0);
+    });
+
+    PeerTable::Slots slots;
+    slots.reserve(peerCount);
+    test("table find", [&] {
+        table.findAbove(PeerTable::Metric::RoundTripTime, threshold, slots);
+        return slots.size();
+    });
+
+    test("table count", [&] {
+        return table.countAbove(PeerTable::Metric::RoundTripTime, threshold);
+    });
+}
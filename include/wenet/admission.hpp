@@ -0,0 +1,68 @@
+#ifndef SQ_WENET_ADMISSION_HPP
+#define SQ_WENET_ADMISSION_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <array>
+
+namespace sq {
+
+namespace wenet {
+
+// Stateless connection admission. First contact from an address is answered
+// with a keyed cookie instead of allocating a peer, ENet is only allowed to
+// see the connection attempt once the cookie has been echoed back, which
+// spoofed sources cannot do. Both sides need admission enabled, the
+// connecting one answers cookies it receives
+class Admission {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t challenged; // connection attempts answered with a cookie
+        size_t admitted; // cookies echoed correctly
+        size_t rejected; // cookies echoed incorrectly or too late
+    };
+
+public:
+    Admission();
+
+    bool isEnabled() const noexcept { return enabled_; }
+    void setEnabled(bool enabled) noexcept { enabled_ = enabled; }
+
+    // Looks at the datagram just received by the host, true if it was
+    // consumed and must not be seen by ENet
+    bool intercept(ENetHost& host, Clock::time_point now) noexcept;
+
+    Stats getStats() const noexcept { return stats_; }
+
+private:
+    struct Ticket {
+        ENetAddress address;
+        Clock::time_point expiry;
+    };
+
+    uint64_t getCookie(const ENetAddress& address,
+                       uint64_t slot) const noexcept;
+    Ticket& getTicket(const ENetAddress& address) noexcept;
+
+    void challenge(ENetHost& host, Clock::time_point now) noexcept;
+    void verify(ENetHost& host, span<const byte> data,
+                Clock::time_point now) noexcept;
+    void answer(ENetHost& host, span<const byte> data) noexcept;
+
+private:
+    bool enabled_ = false;
+    std::array<uint64_t, 2> key_;
+    std::array<Ticket, 256> tickets_{};
+    Stats stats_{0, 0, 0};
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
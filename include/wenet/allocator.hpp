@@ -0,0 +1,65 @@
+#ifndef SQ_WENET_ALLOCATOR_HPP
+#define SQ_WENET_ALLOCATOR_HPP
+
+#include "belks/base.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace sq {
+
+namespace wenet {
+
+// Allocator for everything ENet allocates: peers, channels, commands,
+// fragments, acknowledgements and packets. Small blocks come from size
+// classes with a free list cached per thread, batches of blocks move between
+// the threads and a shared pool. Blocks are carved out of large chunks which
+// can be backed by transparent hugepages, chunks are kept for reuse until the
+// process exits. Bigger blocks go to malloc, all of them are counted
+class Allocator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+    struct Settings {
+        bool hugePages; // advise transparent hugepages for new chunks
+        size_t chunkSize; // bytes reserved from the system at once
+    };
+
+    struct Stats {
+        size_t live; // bytes allocated and not freed yet
+        size_t peak; // most live bytes at any time
+        size_t reserved; // chunks and big blocks taken from the system
+        uint64_t allocations;
+        uint64_t frees;
+        Clock::time_point time;
+    };
+
+    static constexpr size_t MaxSmall = 16384; // bigger blocks use malloc
+
+public:
+    // Routes ENet allocations here for the rest of the process. Blocks cannot
+    // move between allocators, so call it before anything allocates through
+    // ENet (creating a Host or a Packet). Calling it again only changes the
+    // settings of chunks reserved from then on
+    static void install(const Settings& settings={false, 1u << 21});
+    static bool isInstalled() noexcept;
+    static Settings getSettings() noexcept;
+
+    static Stats getStats() noexcept;
+    // Allocations per second between two snapshots
+    static double getRate(const Stats& from, const Stats& to) noexcept;
+
+    // ENet callbacks, null when out of memory
+    static void* allocate(size_t size) noexcept;
+    static void release(void* memory) noexcept;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
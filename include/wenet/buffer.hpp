@@ -0,0 +1,79 @@
+#ifndef SQ_WENET_BUFFER_HPP
+#define SQ_WENET_BUFFER_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <atomic>
+
+namespace sq {
+
+namespace wenet {
+
+namespace buffer_detail {
+
+// Allocated once per buffer, followed by the data unless memory is external
+struct Block {
+    using Release = void (*)(span<byte> data, void* context);
+
+    std::atomic<size_t> references;
+    span<byte> data;
+    Release release;
+    void* context;
+};
+
+void retain(Block& block) noexcept;
+void release(Block& block) noexcept;
+
+} // \buffer_detail
+
+// Reference counted memory backing any number of unmanaged packets. Every
+// packet made from the buffer (or its slice) holds a reference, which is
+// dropped by ENet once the packet is destroyed without allocating anything
+class SharedBuffer {
+public:
+    using Release = buffer_detail::Block::Release;
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    SharedBuffer() noexcept = default;
+    explicit SharedBuffer(size_t size);
+    explicit SharedBuffer(span<const byte> data);
+    // Takes over external memory (i.e. an arena), release is invoked once the
+    // last reference is gone
+    SharedBuffer(span<byte> data, Release release, void* context=nullptr);
+
+    SharedBuffer(const SharedBuffer& buffer) noexcept;
+    SharedBuffer(SharedBuffer&& buffer) noexcept;
+    SharedBuffer& operator = (SharedBuffer buffer) noexcept;
+    ~SharedBuffer() noexcept;
+
+    // Shares memory, offset and size are relative to this view
+    SharedBuffer slice(size_t offset, size_t size) const;
+
+    span<byte> getData() const noexcept { return data_; }
+    size_t getSize() const noexcept { return data_.size(); }
+    size_t getReferences() const noexcept;
+
+    bool isInit() const noexcept { return block_; }
+
+    // Packet pointing into the view, owned by the caller until sent
+    ENetPacket& createPacket(uint32_t flags) const noexcept;
+
+private:
+    static void ENET_CALLBACK onPacketFree(ENetPacket* packet);
+
+private:
+    buffer_detail::Block* block_ = nullptr;
+    span<byte> data_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SQ_WENET_CAPTURE_HPP
+#define SQ_WENET_CAPTURE_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <unordered_map>
+
+#include "wenet/stream.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+class Host;
+
+// Captured datagram, time is relative to the start of the capture
+struct CaptureRecord {
+    std::chrono::nanoseconds time;
+    ENetAddress address;
+    span<const byte> data;
+};
+
+// Writes received datagrams into a memory mapped log file of fixed size,
+// datagrams that do not fit are counted and dropped. The log is in native
+// byte order and meant to be replayed on the same kind of machine
+class Capture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    Capture(cstring_span<> path, size_t size);
+
+    bool write(const ENetAddress& address, span<const byte> data,
+               Clock::time_point now) noexcept;
+
+    size_t getSize() const noexcept { return used_; }
+    size_t getDropped() const noexcept { return dropped_; }
+
+private:
+    MappedFile file_;
+    Clock::time_point start_;
+    size_t used_;
+    size_t dropped_ = 0;
+};
+
+class CaptureReader {
+public:
+    explicit CaptureReader(cstring_span<> path);
+
+    // False once all records have been read
+    bool next(CaptureRecord& record) noexcept;
+    void rewind() noexcept;
+
+private:
+    MappedFile file_;
+    size_t end_;
+    size_t position_;
+};
+
+// Feeds captured datagrams to a host over loopback, from one socket per
+// captured source address so that each source is still a separate peer.
+// Host has to be fresh and configured the same way as the captured one for
+// ENet to accept the replayed handshakes
+class Replay {
+public:
+    struct Stats {
+        size_t datagrams;
+        size_t bytes;
+        std::chrono::nanoseconds elapsed;
+    };
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    explicit Replay(cstring_span<> path);
+    Replay(const Replay&) = delete;
+    ~Replay() noexcept;
+
+    // Keeps original pacing if realtime, otherwise sends as fast as the host
+    // manages to service the datagrams
+    Stats run(Host& host, bool realtime=false);
+
+private:
+    ENetSocket getSocket(const ENetAddress& source);
+
+private:
+    CaptureReader reader_;
+    std::unordered_map<uint64_t, ENetSocket> sockets_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
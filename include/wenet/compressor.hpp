@@ -8,6 +8,9 @@
 #include <zlib.h>
 
 #include <functional>
+#include <memory>
+#include <vector>
+#include <bitset>
 #include <array>
 
 namespace sq {
@@ -27,11 +30,105 @@ public:
     };
 
 public:
+    // owned through base pointers, which point into the virtual base
+    virtual ~Compressor() noexcept = default;
+
     virtual size_t compress(wrapper::BufferVector&& in, size_t inLen,
                             span<byte> out) noexcept = 0;
     virtual size_t decompress(span<const byte> in, span<byte> out) noexcept = 0;
 };
 
+// Compresses whole packets on enabled channels once, before they are queued
+// for any number of peers, instead of every datagram for every peer. Each
+// packet on such channel starts with a one byte header telling whether the
+// rest is compressed
+class PacketCompression {
+public:
+    Compressor* getCompressor() const noexcept { return compressor_.get(); }
+    void setCompressor(std::unique_ptr<Compressor> compressor) noexcept;
+
+    bool isEnabled(uint8_t channelId) const noexcept;
+    void enable(uint8_t channelId) noexcept { channels_.set(channelId); }
+    void disable(uint8_t channelId) noexcept { channels_.reset(channelId); }
+
+    // In place and only once, packets that have been compressed already are
+    // left as they are
+    void compress(uint8_t channelId, ENetPacket& packet);
+
+    // Returns packet to be delivered (either the same or a new one) or
+    // nullptr if packet is malformed
+    ENetPacket* decompress(ENetPacket& packet);
+
+private:
+    void rewrite(ENetPacket& packet, span<const byte> data) const noexcept;
+
+private:
+    std::unique_ptr<Compressor> compressor_;
+    std::bitset<256> channels_;
+    std::vector<byte> buffer_;
+};
+
+// Keeps a zlib deflate and inflate stream for every peer and enabled channel
+// and flushes them at packet boundaries, so every packet is compressed with
+// the history of all packets before it instead of an empty window. That only
+// works when packets arrive in order and none are lost, so just reliable
+// packets go through the streams, others are sent as they are. Every peer has
+// its own history, so the packet is copied for every peer it is sent to
+class StatefulCompression {
+public:
+    // Both sides need the same window, memory per peer and channel is about
+    // 2^(windowBits + 2) + 2^(memLevel + 9) for sending and 2^windowBits for
+    // receiving, streams are created on first use
+    struct Settings {
+        int level; // 1 (fastest) to 9 (smallest)
+        int windowBits; // 9 to 15
+        int memLevel; // 1 to 9
+    };
+
+public:
+    explicit StatefulCompression(size_t peerCount);
+    StatefulCompression(const StatefulCompression&) = delete;
+    ~StatefulCompression() noexcept;
+
+    const Settings& getSettings() const noexcept { return settings_; }
+    // Applies to streams created from then on
+    void setSettings(const Settings& settings) noexcept;
+
+    bool isEnabled(uint8_t channelId) const noexcept;
+    void enable(uint8_t channelId) noexcept { channels_.set(channelId); }
+    void disable(uint8_t channelId) noexcept { channels_.reset(channelId); }
+
+    // Returns a new packet for the peer, nullptr if compression failed (the
+    // stream is then out of sync with the other side)
+    ENetPacket* compress(const ENetPeer& peer, uint8_t channelId,
+                         const ENetPacket& packet);
+
+    // Returns packet to be delivered (either the same or a new one) or
+    // nullptr if packet is malformed
+    ENetPacket* decompress(const ENetPeer& peer, uint8_t channelId,
+                           ENetPacket& packet);
+
+    // Drops the streams of the peer, for a new connection
+    void reset(const ENetPeer& peer) noexcept;
+
+private:
+    struct Stream;
+
+    struct Channel {
+        uint8_t id;
+        std::unique_ptr<Stream> stream;
+    };
+    using Slot = std::vector<Channel>; // few channels, searched in order
+
+    Stream& getStream(const ENetPeer& peer, uint8_t channelId);
+
+private:
+    Settings settings_{6, 15, 8};
+    std::vector<Slot> slots_;
+    std::bitset<256> channels_;
+    std::vector<byte> buffer_;
+};
+
 namespace compressor_detail {
 
 template <typename T>
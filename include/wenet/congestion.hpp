@@ -0,0 +1,100 @@
+#ifndef SQ_WENET_CONGESTION_HPP
+#define SQ_WENET_CONGESTION_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <vector>
+#include <array>
+
+#include "wenet/units.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+// Rate based congestion control in the style of BBR. Models the path to each
+// peer by its bottleneck bandwidth (windowed max of delivery rate) and
+// minimum round trip time, and limits how many bytes the channel scheduler
+// may hand over to ENet to pace sends at the estimated rate
+class CongestionControl {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode {
+        Startup, // exponential growth until bandwidth stops increasing
+        Drain, // empty the queue built during startup
+        ProbeBandwidth // cruise at estimated rate, periodically probe for more
+    };
+
+public:
+    explicit CongestionControl(size_t peerCount);
+
+    void reset(const ENetPeer& peer) noexcept;
+
+    // Takes a sample of the path, returns number of bytes that can be
+    // handed over to ENet right now
+    size_t update(ENetPeer& peer, bool pending, Clock::time_point now) noexcept;
+
+    // Bytes handed over to ENet after update(), reliable of them in reliable
+    // packets. Only acknowledged reliable data counts as delivered, so a peer
+    // sent nothing reliable is paced at the initial estimate
+    void onSent(const ENetPeer& peer, size_t bytes, size_t reliable) noexcept;
+
+    Mode getMode(const ENetPeer& peer) const noexcept;
+    speed::bs getBandwidth(const ENetPeer& peer) const noexcept;
+    speed::bs getPacingRate(const ENetPeer& peer) const noexcept;
+    time::ms getMinRoundTripTime(const ENetPeer& peer) const noexcept;
+
+private:
+    struct Sample {
+        uint32_t round;
+        uint32_t value;
+    };
+
+    struct Slot {
+        Mode mode = Mode::Startup;
+
+        uint64_t reliable = 0; // reliable bytes handed over to ENet so far
+        uint64_t delivered = 0; // at the start of the current sample
+        Clock::time_point sampleStart;
+        uint32_t round = 0;
+
+        std::array<Sample, 3> bandwidth{}; // windowed max, bytes per second
+        uint32_t minRtt = 0; // ms
+        Clock::time_point minRttStamp;
+
+        uint32_t fullBandwidth = 0;
+        uint32_t fullRounds = 0;
+        uint32_t checkedRound = 0;
+
+        size_t cycle = 0;
+        Clock::time_point cycleStart;
+
+        double tokens = 0;
+        Clock::time_point refill;
+        bool started = false;
+    };
+
+    Slot& getSlot(const ENetPeer& peer) noexcept;
+    const Slot& getSlot(const ENetPeer& peer) const noexcept;
+
+    void sample(Slot& slot, ENetPeer& peer, uint64_t delivered, bool pending,
+                Clock::time_point now) noexcept;
+    void advance(Slot& slot, ENetPeer& peer, size_t inFlight,
+                 Clock::time_point now) noexcept;
+
+    double getPacingGain(const Slot& slot, const ENetPeer& peer) const noexcept;
+    uint32_t getEstimate(const Slot& slot, const ENetPeer& peer) const noexcept;
+
+private:
+    std::vector<Slot> slots_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
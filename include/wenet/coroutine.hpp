@@ -0,0 +1,584 @@
+#ifndef SQ_WENET_COROUTINE_HPP
+#define SQ_WENET_COROUTINE_HPP
+
+#include "belks/base.hpp"
+
+#if !defined(__cpp_impl_coroutine)
+#error "wenet/coroutine.hpp requires C++20 coroutine support"
+#endif
+
+#include <enet/enet.h>
+
+#include <coroutine>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <exception>
+#include <algorithm>
+
+#include "wenet/host.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+namespace coro {
+
+class Scheduler;
+
+namespace coro_detail {
+
+// Size-classed free lists for coroutine frames, so that starting and
+// finishing a flow does not touch the global allocator once warmed up
+class FramePool {
+    struct Block { Block* next; };
+
+public:
+    static constexpr size_t Granularity = 64;
+    static constexpr size_t Classes = 64; // frames up to 4 KiB are pooled
+
+public:
+    FramePool() noexcept = default;
+    FramePool(const FramePool&) = delete;
+
+    ~FramePool() noexcept
+    {
+        for (auto block : free_) {
+            while (block) {
+                auto next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+    }
+
+    void* allocate(size_t size)
+    {
+        const auto index = (size + Granularity - 1) / Granularity;
+        if (index >= Classes) return ::operator new(size);
+
+        if (auto block = free_[index]) {
+            free_[index] = block->next;
+            return block;
+        }
+        return ::operator new(index * Granularity);
+    }
+
+    void deallocate(void* frame, size_t size) noexcept
+    {
+        const auto index = (size + Granularity - 1) / Granularity;
+        if (index >= Classes) return ::operator delete(frame);
+
+        auto block = static_cast<Block*>(frame);
+        block->next = free_[index];
+        free_[index] = block;
+    }
+
+    static FramePool& local() noexcept
+    {
+        thread_local FramePool pool;
+        return pool;
+    }
+
+private:
+    std::array<Block*, Classes> free_{};
+};
+
+// Intrusive wait record living inside the suspended coroutine frame
+struct Waiter {
+    using Clock = std::chrono::steady_clock;
+
+    enum class Kind { Connect, Receive, Sleep };
+
+    static constexpr size_t NoTimer = size_t(-1);
+
+    Waiter(Scheduler& scheduler, Kind kind, ENetPeer* peer=nullptr,
+           uint8_t channelId=0) noexcept
+        : scheduler(&scheduler), kind(kind), peer(peer), channelId(channelId)
+    { }
+
+    Waiter(Scheduler& scheduler, Kind kind, Clock::time_point deadline,
+           ENetPeer* peer=nullptr, uint8_t channelId=0) noexcept
+        : scheduler(&scheduler), kind(kind), peer(peer), channelId(channelId),
+          timed(true), deadline(deadline)
+    { }
+
+    Waiter(const Waiter&) = delete;
+    Waiter& operator = (const Waiter&) = delete;
+
+    inline ~Waiter() noexcept;
+
+    Scheduler* scheduler;
+    Kind kind;
+    ENetPeer* peer;
+    uint8_t channelId;
+    std::coroutine_handle<> handle;
+
+    bool timed = false;
+    Clock::time_point deadline;
+    size_t timer = NoTimer;
+
+    bool linked = false;
+    Waiter* prev = nullptr;
+    Waiter* next = nullptr;
+};
+
+} // \coro_detail
+
+// Fire-and-forget coroutine type, starts eagerly and frees its frame when
+// it runs to completion. Exceptions must not escape a flow
+class Flow {
+public:
+    struct promise_type {
+        Flow get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        static void* operator new(size_t size)
+        {
+            return coro_detail::FramePool::local().allocate(size);
+        }
+
+        static void operator delete(void* frame, size_t size) noexcept
+        {
+            coro_detail::FramePool::local().deallocate(frame, size);
+        }
+    };
+};
+
+class ConnectAwaiter : private coro_detail::Waiter {
+    friend class Scheduler;
+
+public:
+    bool await_ready() const noexcept { return false; }
+    inline void await_suspend(std::coroutine_handle<> handle);
+    std::optional<Peer> await_resume() noexcept { return std::move(result_); }
+
+private:
+    ConnectAwaiter(Scheduler& scheduler, ENetPeer& peer) noexcept
+        : Waiter(scheduler, Kind::Connect, &peer) { }
+
+private:
+    std::optional<Peer> result_;
+};
+
+class ReceiveAwaiter : private coro_detail::Waiter {
+    friend class Scheduler;
+
+public:
+    bool await_ready() const noexcept { return false; }
+    inline void await_suspend(std::coroutine_handle<> handle);
+    std::optional<Packet> await_resume() noexcept { return std::move(result_); }
+
+private:
+    ReceiveAwaiter(Scheduler& scheduler, ENetPeer& peer,
+                   uint8_t channelId) noexcept
+        : Waiter(scheduler, Kind::Receive, &peer, channelId) { }
+    ReceiveAwaiter(Scheduler& scheduler, ENetPeer& peer, uint8_t channelId,
+                   Clock::time_point deadline) noexcept
+        : Waiter(scheduler, Kind::Receive, deadline, &peer, channelId) { }
+
+private:
+    std::optional<Packet> result_;
+};
+
+class SleepAwaiter : private coro_detail::Waiter {
+    friend class Scheduler;
+
+public:
+    bool await_ready() const noexcept { return false; }
+    inline void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept { }
+
+private:
+    SleepAwaiter(Scheduler& scheduler, Clock::time_point deadline) noexcept
+        : Waiter(scheduler, Kind::Sleep, deadline) { }
+};
+
+// Resumes coroutines suspended on a host from within its service() calls.
+// Takes over host callbacks, events nobody awaits are forwarded to the
+// callbacks set on the scheduler
+class Scheduler {
+    friend struct coro_detail::Waiter;
+    friend class ConnectAwaiter;
+    friend class ReceiveAwaiter;
+    friend class SleepAwaiter;
+
+    using Waiter = coro_detail::Waiter;
+    using Clock = Waiter::Clock;
+
+    struct Bucket {
+        Waiter* head = nullptr;
+        Waiter* tail = nullptr;
+    };
+
+public:
+    inline explicit Scheduler(Host& host);
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator = (const Scheduler&) = delete;
+    inline ~Scheduler() noexcept;
+
+    Host& getHost() const noexcept { return *host_; }
+
+    // Awaitables
+
+    inline ConnectAwaiter connect(const Address& address);
+    inline ConnectAwaiter connect(const Address& address, size_t channelCount,
+                                  uint32_t data=0);
+
+    inline ReceiveAwaiter receive(const Peer& peer,
+                                  uint8_t channelId=0) noexcept;
+    inline ReceiveAwaiter receive(const Peer& peer, uint8_t channelId,
+                                  time::ms timeout) noexcept;
+
+    inline ReceiveAwaiter request(const Peer& peer, Packet&& packet,
+                                  uint8_t channelId=0) noexcept;
+    inline ReceiveAwaiter request(const Peer& peer, Packet&& packet,
+                                  uint8_t channelId, time::ms timeout) noexcept;
+
+    inline SleepAwaiter sleep(time::ms duration) noexcept;
+
+    // Unawaited events
+
+    void onReceive(Host::Callback callback) noexcept
+    {
+        cbReceive_ = std::move(callback);
+    }
+
+    void onConnect(Host::ConnectCallback callback) noexcept
+    {
+        cbConnect_ = std::move(callback);
+    }
+
+    void onDisconnect(Host::DisconnectCallback callback) noexcept
+    {
+        cbDisconnect_ = std::move(callback);
+    }
+
+    // Service, waits no longer than the closest awaiter timeout
+
+    bool service(int limit=0) { return service(time::ms{0}, limit); }
+    inline bool service(time::ms timeout, int limit=0);
+
+    size_t getPending() const noexcept { return pending_; }
+
+private:
+    inline void wait(Waiter& waiter, std::coroutine_handle<> handle);
+    inline void detach(Waiter& waiter) noexcept;
+
+    inline Waiter* find(ENetPeer& peer, Waiter::Kind kind,
+                        uint8_t channelId=0) noexcept;
+    inline Bucket& getBucket(ENetPeer& peer) noexcept;
+
+    inline void handleConnect(Peer& peer, uint32_t data);
+    inline void handleReceive(Peer& peer, Packet&& packet, uint8_t channelId);
+    inline void handleDisconnect(size_t peerId, uint32_t data);
+    inline void expireTimers();
+
+    inline void pushTimer(Waiter& waiter);
+    inline void eraseTimer(Waiter& waiter) noexcept;
+    inline void siftTimer(size_t index) noexcept;
+    inline void swapTimers(size_t a, size_t b) noexcept;
+
+private:
+    Host* host_;
+    Host::Callback cbReceive_;
+    Host::ConnectCallback cbConnect_;
+    Host::DisconnectCallback cbDisconnect_;
+
+    std::vector<Bucket> buckets_;
+    std::vector<Waiter*> timers_; // binary min-heap on deadline
+    size_t pending_ = 0;
+};
+
+// Waiter
+
+coro_detail::Waiter::~Waiter() noexcept
+{
+    scheduler->detach(*this);
+}
+
+// Awaiters
+
+void ConnectAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    scheduler->wait(*this, handle);
+}
+
+void ReceiveAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    scheduler->wait(*this, handle);
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    scheduler->wait(*this, handle);
+}
+
+// Scheduler
+
+Scheduler::Scheduler(Host& host)
+    : host_(&host), buckets_(host.getPeerLimit())
+{
+    host_->onConnect([this](Peer& peer, uint32_t data) {
+        handleConnect(peer, data);
+    });
+    host_->onReceive([this](Peer& peer, Packet&& packet, uint8_t channelId) {
+        handleReceive(peer, std::move(packet), channelId);
+    });
+    host_->onDisconnect([this](size_t peerId, uint32_t data) {
+        handleDisconnect(peerId, data);
+    });
+}
+
+Scheduler::~Scheduler() noexcept
+{
+    host_->onConnect({});
+    host_->onReceive({});
+    host_->onDisconnect({});
+
+    // destroying a suspended frame runs the awaiter destructor which
+    // detaches it, so always take the first remaining waiter
+    for (auto& bucket : buckets_) {
+        while (bucket.head) bucket.head->handle.destroy();
+    }
+    while (!timers_.empty()) timers_.front()->handle.destroy();
+}
+
+ConnectAwaiter Scheduler::connect(const Address& address)
+{
+    return connect(address, host_->getChannelLimit());
+}
+
+ConnectAwaiter Scheduler::connect(const Address& address, size_t channelCount,
+                                  uint32_t data)
+{
+    auto& peer = host_->connect(address, channelCount, data);
+    return {*this, *static_cast<ENetPeer*>(peer)};
+}
+
+ReceiveAwaiter Scheduler::receive(const Peer& peer, uint8_t channelId) noexcept
+{
+    return {*this, *static_cast<ENetPeer*>(peer), channelId};
+}
+
+ReceiveAwaiter Scheduler::receive(const Peer& peer, uint8_t channelId,
+                                  time::ms timeout) noexcept
+{
+    return {
+        *this, *static_cast<ENetPeer*>(peer), channelId, Clock::now() + timeout
+    };
+}
+
+ReceiveAwaiter Scheduler::request(const Peer& peer, Packet&& packet,
+                                  uint8_t channelId) noexcept
+{
+    peer.send(std::move(packet), channelId);
+    return receive(peer, channelId);
+}
+
+ReceiveAwaiter Scheduler::request(const Peer& peer, Packet&& packet,
+                                  uint8_t channelId, time::ms timeout) noexcept
+{
+    peer.send(std::move(packet), channelId);
+    return receive(peer, channelId, timeout);
+}
+
+SleepAwaiter Scheduler::sleep(time::ms duration) noexcept
+{
+    return {*this, Clock::now() + duration};
+}
+
+bool Scheduler::service(time::ms timeout, int limit)
+{
+    if (!timers_.empty()) {
+        const auto left = timers_.front()->deadline - Clock::now();
+        const auto wait = std::chrono::ceil<time::ms>(left);
+        if (wait <= time::ms{0}) timeout = time::ms{0};
+        else if (wait < timeout) timeout = wait;
+    }
+
+    const auto result = host_->service(timeout, limit);
+    expireTimers();
+    return result;
+}
+
+void Scheduler::wait(Waiter& waiter, std::coroutine_handle<> handle)
+{
+    // the only step that can throw goes first, the awaiting coroutine gets
+    // the exception back from co_await with nothing linked yet
+    if (waiter.timed) pushTimer(waiter);
+
+    waiter.handle = handle;
+    ++pending_;
+
+    if (waiter.peer) {
+        auto& bucket = getBucket(*waiter.peer);
+        waiter.prev = bucket.tail;
+        if (bucket.tail) bucket.tail->next = &waiter;
+        else bucket.head = &waiter;
+        bucket.tail = &waiter;
+    }
+    waiter.linked = true;
+}
+
+void Scheduler::detach(Waiter& waiter) noexcept
+{
+    if (!waiter.linked) return;
+
+    if (waiter.peer) {
+        auto& bucket = getBucket(*waiter.peer);
+        if (waiter.prev) waiter.prev->next = waiter.next;
+        else bucket.head = waiter.next;
+        if (waiter.next) waiter.next->prev = waiter.prev;
+        else bucket.tail = waiter.prev;
+        waiter.prev = waiter.next = nullptr;
+    }
+    if (waiter.timer != Waiter::NoTimer) eraseTimer(waiter);
+
+    waiter.linked = false;
+    --pending_;
+}
+
+Scheduler::Waiter* Scheduler::find(ENetPeer& peer, Waiter::Kind kind,
+                                   uint8_t channelId) noexcept
+{
+    for (auto waiter = getBucket(peer).head; waiter; waiter = waiter->next) {
+        if (waiter->kind != kind) continue;
+        if (kind == Waiter::Kind::Receive && waiter->channelId != channelId) {
+            continue;
+        }
+        return waiter;
+    }
+    return nullptr;
+}
+
+Scheduler::Bucket& Scheduler::getBucket(ENetPeer& peer) noexcept
+{
+    ENetHost* host = *host_;
+    return buckets_[size_t(&peer - host->peers)];
+}
+
+void Scheduler::handleConnect(Peer& peer, uint32_t data)
+{
+    auto waiter = find(*static_cast<ENetPeer*>(peer), Waiter::Kind::Connect);
+    if (!waiter) {
+        if (cbConnect_) cbConnect_(peer, data);
+        return;
+    }
+
+    auto& awaiter = static_cast<ConnectAwaiter&>(*waiter);
+    detach(awaiter);
+    awaiter.result_ = peer;
+    awaiter.handle.resume();
+}
+
+void Scheduler::handleReceive(Peer& peer, Packet&& packet, uint8_t channelId)
+{
+    auto waiter = find(*static_cast<ENetPeer*>(peer), Waiter::Kind::Receive,
+                       channelId);
+    if (!waiter) {
+        if (cbReceive_) cbReceive_(peer, std::move(packet), channelId);
+        return;
+    }
+
+    auto& awaiter = static_cast<ReceiveAwaiter&>(*waiter);
+    detach(awaiter);
+    awaiter.result_ = std::move(packet);
+    awaiter.handle.resume();
+}
+
+void Scheduler::handleDisconnect(size_t peerId, uint32_t data)
+{
+    const auto peers = host_->getPeers();
+    const auto owner = std::find_if(peers.begin(), peers.end(),
+        [peerId](const Peer& peer) { return peer.getId() == peerId; });
+    if (owner == peers.end()) {
+        if (cbDisconnect_) cbDisconnect_(peerId, data);
+        return;
+    }
+    auto& peer = *static_cast<ENetPeer*>(*owner);
+
+    // everything awaiting this peer resumes empty-handed, waiters added
+    // while resuming are appended to the tail and stay suspended
+    auto& bucket = getBucket(peer);
+    auto count = 0u;
+    for (auto waiter = bucket.head; waiter; waiter = waiter->next) ++count;
+    while (count--) {
+        auto& waiter = *bucket.head;
+        detach(waiter);
+        waiter.handle.resume();
+    }
+
+    if (cbDisconnect_) cbDisconnect_(peerId, data);
+}
+
+void Scheduler::expireTimers()
+{
+    const auto now = Clock::now();
+    while (!timers_.empty() && timers_.front()->deadline <= now) {
+        auto& waiter = *timers_.front();
+        detach(waiter);
+        waiter.handle.resume();
+    }
+}
+
+void Scheduler::pushTimer(Waiter& waiter)
+{
+    timers_.push_back(&waiter);
+    waiter.timer = timers_.size() - 1;
+    siftTimer(waiter.timer);
+}
+
+void Scheduler::eraseTimer(Waiter& waiter) noexcept
+{
+    const auto index = waiter.timer;
+    swapTimers(index, timers_.size() - 1);
+    timers_.pop_back();
+    waiter.timer = Waiter::NoTimer;
+
+    if (index < timers_.size()) siftTimer(index);
+}
+
+void Scheduler::siftTimer(size_t index) noexcept
+{
+    // up
+    while (index) {
+        const auto parent = (index - 1) / 2;
+        if (timers_[parent]->deadline <= timers_[index]->deadline) break;
+        swapTimers(index, parent);
+        index = parent;
+    }
+
+    // down
+    while (true) {
+        auto smallest = index;
+        for (auto child : {index * 2 + 1, index * 2 + 2}) {
+            if (child >= timers_.size()) break;
+            if (timers_[child]->deadline < timers_[smallest]->deadline) {
+                smallest = child;
+            }
+        }
+        if (smallest == index) break;
+        swapTimers(index, smallest);
+        index = smallest;
+    }
+}
+
+void Scheduler::swapTimers(size_t a, size_t b) noexcept
+{
+    std::swap(timers_[a], timers_[b]);
+    timers_[a]->timer = a;
+    timers_[b]->timer = b;
+}
+
+} // \coro
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SQ_WENET_CORRECTION_HPP
+#define SQ_WENET_CORRECTION_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <array>
+#include <bitset>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+// Forward error correction for large unreliable packets. Instead of letting
+// ENet fragment them, a packet is split into data shards that fit a datagram
+// each, plus XOR parity shards over interleaved stripes of them. Every
+// parity shard can rebuild one lost data shard of its stripe, so a packet
+// arrives despite lost datagrams without waiting for a retransmission.
+// Other packets on the channel are sent whole with a one byte header
+class ErrorCorrection {
+public:
+    struct Settings {
+        size_t stripe; // data shards per parity shard, at least 1
+        size_t shardSize; // payload bytes per shard, 0 fits the peer's mtu
+    };
+
+    struct Stats {
+        size_t recovered; // packets rebuilt with parity shards
+        size_t incomplete; // packets given up on, too many shards lost
+    };
+
+public:
+    explicit ErrorCorrection(size_t peerCount);
+    ErrorCorrection(const ErrorCorrection&) = delete;
+
+    const Settings& getSettings() const noexcept { return settings_; }
+    void setSettings(const Settings& settings) noexcept;
+    const Stats& getStats() const noexcept { return stats_; }
+
+    bool isEnabled(uint8_t channelId) const noexcept;
+    void enable(uint8_t channelId) noexcept { channels_.set(channelId); }
+    void disable(uint8_t channelId) noexcept { channels_.reset(channelId); }
+
+    // New packets to send to the peer in place of the packet, valid until
+    // the next call. Empty if they could not be created
+    span<ENetPacket* const> encode(const ENetPeer& peer,
+                                   const ENetPacket& packet);
+
+    // Returns packet to be delivered (either the same or a new one), nullptr
+    // if packet is malformed or a shard of a packet not complete yet
+    ENetPacket* decode(const ENetPeer& peer, uint8_t channelId,
+                       ENetPacket& packet);
+
+    // Drops partly received packets of the peer, for a new connection
+    void reset(const ENetPeer& peer) noexcept;
+
+private:
+    struct Group {
+        uint32_t id = 0;
+        size_t data = 0;
+        size_t parity = 0;
+        size_t size = 0;
+        size_t shardSize = 0;
+        std::vector<byte> shards; // (data + parity) * shardSize
+        std::vector<bool> received;
+        size_t count = 0;
+        bool used = false;
+        bool done = false;
+    };
+
+    struct Channel {
+        uint8_t id;
+        std::array<Group, 4> groups; // packets being received
+    };
+    using Slot = std::vector<Channel>; // few channels, searched in order
+
+    Group* getGroup(Channel& channel, uint32_t id) noexcept;
+    ENetPacket* rebuild(Group& group, uint32_t flags);
+    Channel& getChannel(const ENetPeer& peer, uint8_t channelId);
+
+private:
+    Settings settings_{4, 0};
+    Stats stats_{0, 0};
+    std::vector<Slot> slots_;
+    std::bitset<256> channels_;
+    std::vector<ENetPacket*> shards_;
+    uint32_t group_ = 0;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SQ_WENET_EXPIRY_HPP
+#define SQ_WENET_EXPIRY_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <unordered_map>
+
+namespace sq {
+
+namespace wenet {
+
+// Deadlines of queued unreliable packets. A reference to every tracked packet
+// is held, so its address is not reused for another packet while the
+// deadline is known, and it is let go once nothing else holds the packet
+class Expiry {
+public:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    Expiry() = default;
+    Expiry(const Expiry&) = delete;
+    ~Expiry() noexcept;
+
+    // No deadline (default time point) and reliable packets are ignored
+    void track(ENetPacket& packet, Clock::time_point deadline);
+
+    // Forgets packets sent everywhere, true if some tracked ones are late
+    bool update(Clock::time_point now) noexcept;
+    bool isExpired(const ENetPacket& packet) const noexcept;
+    // Forgets the late packets, once they are out of all the queues
+    void release() noexcept;
+
+private:
+    std::unordered_map<ENetPacket*, Clock::time_point> deadlines_;
+    Clock::time_point now_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
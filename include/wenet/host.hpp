@@ -10,12 +10,26 @@
 #include <vector>
 #include <atomic>
 #include <unordered_map>
+#include <chrono>
 
 #include "wenet/peer.hpp"
 #include "wenet/units.hpp"
 #include "wenet/packet.hpp"
 #include "wenet/address.hpp"
 #include "wenet/compressor.hpp"
+#include "wenet/correction.hpp"
+#include "wenet/scheduler.hpp"
+#include "wenet/expiry.hpp"
+#include "wenet/congestion.hpp"
+#include "wenet/pacer.hpp"
+#include "wenet/stream.hpp"
+#include "wenet/admission.hpp"
+#include "wenet/limiter.hpp"
+#include "wenet/capture.hpp"
+#include "wenet/table.hpp"
+#include "wenet/pool.hpp"
+#include "wenet/router.hpp"
+#include "wenet/allocator.hpp"
 #include "convw/convw.hpp"
 
 namespace sq {
@@ -23,6 +37,10 @@ namespace sq {
 namespace wenet {
 
 class Host {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
     struct Deleter { void operator () (ENetHost* host) const noexcept; };
 
     struct Bandwidth {
@@ -30,10 +48,51 @@ class Host {
         speed::bs outgoing;
     };
 
+    // Per peer slot state, indexed the same way as ENetHost::peers
+    struct Slot {
+        size_t queued = 0; // estimate, exact after each flush
+        size_t dropped = 0;
+        std::vector<size_t> expired; // per channel, grows on demand
+        bool high = false;
+    };
+
 public:
+    // Outgoing queue limits per peer in bytes
+    struct Watermark {
+        size_t high;
+        size_t low;
+    };
+
+    // What happens to a packet sent to a peer above the high watermark
+    enum class Overflow {
+        Notify, // queue anyway, only invoke callback
+        DropOldest, // drop oldest queued unreliable packets to make room
+        Reject, // do not queue the packet
+        Disconnect // disconnect the peer immediately (left in getPeers()
+                   // until service() finishes, senders may be holding it)
+    };
+
+    // Work left after service() returned
+    struct Backlog {
+        size_t events; // received and waiting to be dispatched
+        size_t packets; // outgoing packets held back by wenet
+        bool socket; // more datagrams waiting to be read
+    };
+
+    // Spin-then-block polling
+    struct Polling {
+        time::us spin; // longest spin window, 0 disables spinning
+        bool busyPoll; // let the kernel busy poll the device (SO_BUSY_POLL)
+    };
+
+    using Priority = ChannelScheduler::Priority;
+    using StreamWindow = Streams::Window;
+
     using Callback = convw::Convw<void (Peer&, Packet&&, uint8_t)>;
     using ConnectCallback = convw::Convw<void (Peer&, uint32_t)>;
     using DisconnectCallback = convw::Convw<void (size_t, uint32_t)>;
+    using WatermarkCallback = convw::Convw<void (Peer&, size_t)>;
+    using BuildCallback = convw::Convw<Packet (const Peer&)>;
 
     class Exception : public std::runtime_error {
     public: using std::runtime_error::runtime_error;
@@ -52,6 +111,8 @@ public:
     Host(size_t peerCount=1, const ENetAddress* address=nullptr);
     Host(const Address& address, size_t peerCount);
 
+    // Servicing the raw host directly skips admission, rate limiting and
+    // capture, their datagrams are let through as if they were off
     operator ENetHost* () const noexcept { return host_.get(); }
 
     Peer& connect(const Address& address);
@@ -63,26 +124,173 @@ public:
     size_t getChannelLimit() const noexcept { return host_->channelLimit; }
     void setChannelLimit(size_t limit) noexcept;
 
-    void broadcast(Packet& packet, uint8_t channelId=0) const noexcept;
-    void broadcast(Packet&& packet, uint8_t channelId=0) const noexcept;
+    void broadcast(Packet& packet, uint8_t channelId=0) noexcept;
+    void broadcast(Packet&& packet, uint8_t channelId=0) noexcept;
+
+    // Multi-peer sends share the packet between all the peers and skip the
+    // ones not connected, return how many peers it was queued for
+
+    size_t sendTo(span<const Peer* const> peers, Packet&& packet,
+                  uint8_t channelId=0) noexcept;
+    size_t broadcastExcept(const Peer& peer, Packet&& packet,
+                           uint8_t channelId=0) noexcept;
+    template <typename Predicate>
+    size_t broadcastIf(Predicate predicate, Packet&& packet,
+                       uint8_t channelId=0) noexcept;
+
+    // Builds a packet for every peer on the work pool, then sends them in
+    // peer order from the calling thread, so ENet is never used concurrently.
+    // Builds run in parallel and must not send or change shared state, empty
+    // packets are not sent. Returns how many packets were queued
+
+    size_t sendEach(BuildCallback build, uint8_t channelId=0);
+
+    // Threads in addition to the calling one, one per core by default
+    void setWorkThreads(size_t threads);
 
     void onReceive(Callback callback) noexcept;
     void onConnect(ConnectCallback callback) noexcept;
     void onDisconnect(DisconnectCallback callback) noexcept;
 
+    // Message routes, packets whose first byte has a handler on their channel
+    // go to it, everything else to onReceive
+
+    void route(uint8_t channelId, uint8_t messageId, Router::Handler handler,
+               void* context=nullptr);
+    template <typename T>
+    void route(uint8_t channelId, uint8_t messageId, T& handler);
+    void unroute(uint8_t channelId, uint8_t messageId) noexcept;
+
+    // Backpressure
+
+    Watermark getQueueLimit() const noexcept { return watermark_; }
+    Overflow getOverflow() const noexcept { return overflow_; }
+    void setQueueLimit(const Watermark& watermark,
+                       Overflow overflow=Overflow::Notify) noexcept;
+
+    void onHighWatermark(WatermarkCallback callback) noexcept;
+    void onLowWatermark(WatermarkCallback callback) noexcept;
+
+    // Channel priorities (once any is set packets are scheduled by wenet)
+
+    Priority getChannelPriority(uint8_t channelId) const noexcept;
+    void setChannelPriority(uint8_t channelId,
+                            const Priority& priority) noexcept;
+
+    // Congestion control (packets are scheduled by wenet when enabled)
+
+    bool getCongestionControl() const noexcept { return congestionControl_; }
+    void setCongestionControl(bool enabled) noexcept;
+
+    // Send pacing, packets are handed over to ENet no faster than the target
+    // rates and service() wakes up to send more while it waits for events,
+    // so they leave spread over the timeout (scheduled by wenet when enabled)
+
+    const Pacer::Settings& getPacing() const noexcept;
+    void setPacing(const Pacer::Settings& settings) noexcept;
+    Pacer::Gaps getPacingGaps() const noexcept;
+
+    // File streams (sent over a dedicated reliable channel once it is set)
+
+    void setStreamChannel(uint8_t channelId) noexcept;
+    StreamWindow getStreamWindow() const noexcept;
+    void setStreamWindow(const StreamWindow& window) noexcept;
+
+    void onStreamBegin(Streams::BeginCallback callback) noexcept;
+    void onStreamSent(Streams::ProgressCallback callback) noexcept;
+    void onStreamReceived(Streams::ProgressCallback callback) noexcept;
+
+    // Connection admission (stateless cookies against connect floods)
+
+    bool getAdmission() const noexcept { return admission_.isEnabled(); }
+    void setAdmission(bool enabled) noexcept;
+    Admission::Stats getAdmissionStats() const noexcept;
+
+    // Rate limiting of incoming datagrams before ENet parses them
+
+    RateLimiter::Limit getRateLimit() const noexcept;
+    void setRateLimit(const RateLimiter::Limit& limit) noexcept;
+    RateLimiter::Stats getRateLimitStats() const noexcept;
+
+    // Traffic capture, every received datagram is logged before anything
+    // else looks at it, so the log can be replayed to a fresh host
+
+    void startCapture(cstring_span<> path, size_t size);
+    void stopCapture() noexcept;
+    bool isCapturing() const noexcept { return !!capture_; }
+
     bool receive(int limit=0);
     bool service(int limit=0);
     bool service(time::ms timeout, int limit=0);
+    // Dispatches events until there are none or the deadline has passed,
+    // never waits for new ones
+    bool service(Clock::time_point deadline);
+
+    Backlog getBacklog() const noexcept;
+
+    // Like service(timeout) but spins checking the socket before blocking.
+    // Spin window follows how often events arrive and shrinks to nothing
+    // when they are too far apart for spinning to catch the next one
+    bool poll(time::ms timeout);
+
+    // False if busy polling was asked for and the socket refused it (it
+    // needs CAP_NET_ADMIN above net.core.busy_poll), getPolling() then has
+    // it off
+    Polling getPolling() const noexcept { return polling_; }
+    bool setPolling(const Polling& polling) noexcept;
+    time::us getSpinWindow() const noexcept;
 
     void flush();
 
     template <typename Comp> void setCompression();
     void disableCompression() noexcept;
 
+    // Packet compression, packets on the channel are compressed once no
+    // matter how many peers they are sent to (one compressor per host)
+
+    template <typename Comp> void setPacketCompression(uint8_t channelId);
+    void disablePacketCompression(uint8_t channelId) noexcept;
+    bool isPacketCompressed(uint8_t channelId) const noexcept;
+
+    // Stateful compression, every peer keeps a zlib history per channel so
+    // content repeated across reliable packets compresses well. Exclusive
+    // with packet compression on the same channel, see StatefulCompression
+
+    void enableStatefulCompression(uint8_t channelId) noexcept;
+    void disableStatefulCompression(uint8_t channelId) noexcept;
+    bool isStatefullyCompressed(uint8_t channelId) const noexcept;
+    const StatefulCompression::Settings&
+        getStatefulCompression() const noexcept;
+    void setStatefulCompression(
+        const StatefulCompression::Settings& settings) noexcept;
+
+    // State channels, a packet with a key (Packet::setKey) takes the place
+    // of the packet with the same key still queued for the peer instead of
+    // queueing behind it, so a slow peer gets only the latest state. Packets
+    // are scheduled by wenet once enabled. Exclusive with stateful
+    // compression on the same channel
+
+    void enableStateChannel(uint8_t channelId) noexcept;
+    void disableStateChannel(uint8_t channelId) noexcept;
+    bool isStateChannel(uint8_t channelId) const noexcept;
+
+    // Forward error correction, large unreliable packets on the channel are
+    // sent as shards with parity so they survive lost datagrams, see
+    // ErrorCorrection. Exclusive with stateful compression on the same
+    // channel, both sides have to enable it
+
+    void enableErrorCorrection(uint8_t channelId) noexcept;
+    void disableErrorCorrection(uint8_t channelId) noexcept;
+    bool isErrorCorrected(uint8_t channelId) const noexcept;
+    const ErrorCorrection::Settings& getErrorCorrection() const noexcept;
+    void setErrorCorrection(
+        const ErrorCorrection::Settings& settings) noexcept;
+    const ErrorCorrection::Stats& getErrorCorrectionStats() const noexcept;
+
     // Unwrapped callbacks
 
     void _onChecksum(decltype(ENetHost::checksum) callback) const noexcept;
-    void _onIntercept(decltype(ENetHost::intercept) callback) const noexcept;
+    void _onIntercept(decltype(ENetHost::intercept) callback) noexcept;
 
     // Peers
 
@@ -90,6 +298,14 @@ public:
     size_t getPeerLimit() const noexcept { return host_->peerCount; }
     span<Peer> getPeers() noexcept { return gsl::as_span(peers_); }
 
+    // Peer table, a copy of per peer fields refreshed on every service() for
+    // scans over all peers (queries return slots, see getPeerAt)
+
+    bool getPeerTracking() const noexcept { return table_.isEnabled(); }
+    void setPeerTracking(bool enabled) noexcept;
+    const PeerTable& getPeerTable() const noexcept { return table_; }
+    Peer& getPeerAt(size_t slot) noexcept;
+
     // 1.3.9
 #if ENET_VERSION_CREATE(1, 3, 9) <= ENET_VERSION
 
@@ -117,27 +333,281 @@ public:
     uint32_t getTotalSentData() const noexcept;
     uint32_t getTotalSentPackets() const noexcept;
 
+    // Memory ENet holds for all hosts, zero unless Allocator is installed
+    static Allocator::Stats getAllocatorStats() noexcept;
+
     void removePeer(const Peer& peer) noexcept;
 
+protected:
+    // Event loops with delivery as a template parameter, so the sink calls
+    // can be inlined. Deliver has connect(Peer&, uint32_t), receive(Peer&,
+    // Packet&&, uint8_t) and disconnect(size_t, uint32_t), see StaticHost
+
+    template <typename Deliver>
+    bool receiveWith(int limit, Deliver& deliver);
+    template <typename Deliver>
+    bool serviceWith(time::ms timeout, int limit, Deliver& deliver);
+    template <typename Deliver>
+    bool serviceWith(Clock::time_point deadline, Deliver& deliver);
+    template <typename Deliver>
+    bool pollWith(time::ms timeout, Deliver& deliver);
+
 private:
-    void parseEvent(ENetEvent& event);
+    friend class Peer;
+    friend class Streams;
+
+    // Delivery to the callbacks set with onConnect, onReceive, onDisconnect
+    struct Callbacks {
+        Host& host;
+
+        void connect(Peer& peer, uint32_t data);
+        void receive(Peer& peer, Packet&& packet, uint8_t channelId);
+        void disconnect(size_t id, uint32_t data);
+    };
+
+    template <typename Deliver>
+    int serviceOnce(ENetEvent& event, uint32_t timeout, Deliver& deliver);
+    // Dispatches an event ENet has queued already, without touching socket
+    template <typename Deliver>
+    int checkOnce(ENetEvent& event, Deliver& deliver);
+    template <typename Deliver>
+    void parseEvent(ENetEvent& event, Deliver& deliver);
+    int serviceEnet(ENetEvent& event, uint32_t timeout);
+    int servicePaced(ENetEvent& event, uint32_t timeout);
+    ENetPacket* prepareReceive(ENetEvent& event); // null when consumed
+    size_t prepareDisconnect(ENetPeer& peer) noexcept;
+    void finishService();
+    bool isReadable() const noexcept; // without blocking
+    void onArrival(Clock::time_point now) noexcept;
+
+    void updateIntercept() noexcept;
+    static int ENET_CALLBACK intercept(ENetHost* host, ENetEvent* event);
+
+    void broadcastShared(const Packet& packet, uint8_t channelId) noexcept;
+    template <typename Visit>
+    size_t fanOut(Packet&& packet, uint8_t channelId, Visit visit) noexcept;
+
+    bool enqueue(ENetPeer& peer, uint8_t channelId, const Packet& packet);
+    bool enqueueStateful(ENetPeer& peer, uint8_t channelId,
+                         const Packet& packet);
+    bool enqueueCorrected(ENetPeer& peer, uint8_t channelId,
+                          const Packet& packet);
+    bool submit(ENetPeer& peer, uint8_t channelId, ENetPacket& packet,
+                uint64_t key=Packet::NoKey);
+    bool admit(ENetPeer& peer, const Packet& packet);
+    void schedule();
+    void expire();
+    void updateQueues();
+    Slot& getSlot(ENetPeer& peer) noexcept;
 
     Peer& getPeer(ENetPeer& peer) noexcept;
+    Peer* findPeer(ENetPeer& peer) noexcept; // nullptr if it has no Peer
     Peer& createPeer(ENetPeer& peer) noexcept;
     void removePeer(ENetPeer& peer) noexcept;
+    void removeDisconnected() noexcept;
 
 private:
     Address address_;
     Callback cbReceive_;
     ConnectCallback cbConnect_;
     DisconnectCallback cbDisconnect_;
+    WatermarkCallback cbHighWatermark_;
+    WatermarkCallback cbLowWatermark_;
+    Streams streams_; // outlives ENet, which releases the chunks
+    Expiry expiry_; // outlives ENet, which releases the queued packets
     std::unique_ptr<ENetHost, Deleter> host_;
     std::unique_ptr<Compressor> compressor_;
     std::vector<Peer> peers_;
+    std::vector<Slot> slots_;
+    std::vector<ENetPeer*> disconnected_; // by admit, removed from peers_ later
+    ChannelScheduler scheduler_;
+    CongestionControl congestion_;
+    Pacer pacer_;
+    PacketCompression packetCompression_;
+    StatefulCompression statefulCompression_;
+    ErrorCorrection errorCorrection_;
+    Admission admission_;
+    RateLimiter limiter_;
+    PeerTable table_;
+    Router router_;
+    std::unique_ptr<WorkPool> pool_; // created on first use
+    std::vector<Packet> built_;
+    std::vector<ENetPeer*> builtFor_; // peers_ may shrink while sending
+    std::unique_ptr<Capture> capture_;
+    Polling polling_{time::us{0}, false};
+    double arrivalInterval_ = 0; // moving average, us
+    Clock::time_point lastArrival_;
+    decltype(ENetHost::intercept) cbIntercept_ = nullptr;
+    bool congestionControl_ = false;
+    bool paced_ = false; // packets held back by the pacer
+    size_t nextScheduled_ = 0; // peer schedule() starts with
+    Watermark watermark_{0, 0};
+    Overflow overflow_ = Overflow::Notify;
 
     static std::atomic<size_t> objects_;
+    static thread_local Host* servicing_; // intercept has no user data
 };
 
+template <typename Deliver>
+bool Host::receiveWith(int limit, Deliver& deliver)
+{
+    ENetEvent event;
+    do {
+        if (!checkOnce(event, deliver)) return false;
+    } while(--limit);
+    return true;
+}
+
+template <typename Deliver>
+bool Host::serviceWith(time::ms timeout, int limit, Deliver& deliver)
+{
+    schedule();
+
+    ENetEvent event;
+    auto result = 0;
+    do {
+        result = serviceOnce(event, timeout.count(), deliver);
+    } while(result && --limit);
+
+    finishService();
+    return result;
+}
+
+template <typename Deliver>
+bool Host::serviceWith(Clock::time_point deadline, Deliver& deliver)
+{
+    schedule();
+
+    // events left undispatched stay in ENet's queue for the next call
+    ENetEvent event;
+    auto result = 0;
+    do {
+        result = serviceOnce(event, 0, deliver);
+    } while(result && Clock::now() < deadline);
+
+    finishService();
+    return result;
+}
+
+template <typename Deliver>
+bool Host::pollWith(time::ms timeout, Deliver& deliver)
+{
+    schedule();
+
+    ENetEvent event;
+    auto result = 0;
+    const auto window = getSpinWindow();
+    if (window.count()) {
+        // sends queued packets and takes whatever has arrived already
+        result = serviceOnce(event, 0, deliver);
+
+        // spinning takes events ENet has queued and peeks at the socket, it
+        // is only serviced again once a datagram is there
+        const auto start = Clock::now();
+        while (!result && Clock::now() - start < window) {
+            result = checkOnce(event, deliver);
+            if (!result && isReadable()) {
+                result = serviceOnce(event, 0, deliver);
+            }
+        }
+
+        using std::chrono::duration_cast;
+        const auto spent = duration_cast<time::ms>(Clock::now() - start);
+        if (!result && spent < timeout) {
+            result = serviceOnce(event, (timeout - spent).count(), deliver);
+        }
+    }
+    else result = serviceOnce(event, timeout.count(), deliver);
+
+    if (result) onArrival(Clock::now());
+    finishService();
+    return result;
+}
+
+template <typename Deliver>
+int Host::checkOnce(ENetEvent& event, Deliver& deliver)
+{
+    const auto result = enet_host_check_events(host_.get(), &event);
+    if (result < 0) throw ReceiveEventException{"Cannot receive"};
+    if (result > 0) parseEvent(event, deliver);
+    return result;
+}
+
+template <typename Deliver>
+int Host::serviceOnce(ENetEvent& event, uint32_t timeout, Deliver& deliver)
+{
+    const auto result = serviceEnet(event, timeout);
+    if (result > 0) parseEvent(event, deliver);
+    return result;
+}
+
+template <typename Deliver>
+void Host::parseEvent(ENetEvent& event, Deliver& deliver)
+{
+    switch (event.type) {
+    case ENET_EVENT_TYPE_CONNECT:
+        deliver.connect(createPeer(*event.peer), event.data);
+        break;
+
+    case ENET_EVENT_TYPE_RECEIVE: {
+        const auto packet = prepareReceive(event);
+        if (!packet) break;
+
+        auto& peer = getPeer(*event.peer);
+        Packet received{*packet};
+        if (router_.dispatch(peer, received, event.channelID)) break;
+        deliver.receive(peer, std::move(received), event.channelID);
+        break;
+    }
+
+    case ENET_EVENT_TYPE_DISCONNECT:
+        deliver.disconnect(prepareDisconnect(*event.peer), event.data);
+        break;
+
+    default:
+        break;
+    }
+}
+
+template <typename T>
+void Host::route(uint8_t channelId, uint8_t messageId, T& handler)
+{
+    router_.add(channelId, messageId, handler);
+}
+
+template <typename Predicate>
+size_t Host::broadcastIf(Predicate predicate, Packet&& packet,
+                         uint8_t channelId) noexcept
+{
+    // by ENet's peers, peers_ shrinks if the predicate disconnects one
+    return fanOut(std::move(packet), channelId, [&](auto send) {
+        auto peers = span<ENetPeer>{
+            host_->peers, std::ptrdiff_t(host_->peerCount)
+        };
+        for (auto& other : peers) {
+            auto peer = findPeer(other);
+            if (peer && predicate(*peer)) send(other);
+        }
+    });
+}
+
+template <typename Visit>
+size_t Host::fanOut(Packet&& packet, uint8_t channelId, Visit visit) noexcept
+{
+    packet.releaseOwnership();
+    auto& shared = *static_cast<ENetPacket*>(packet);
+    packetCompression_.compress(channelId, shared); // once for all peers
+
+    auto sent = size_t(0);
+    visit([&](ENetPeer& peer) {
+        if (peer.state != ENET_PEER_STATE_CONNECTED) return;
+        sent += enqueue(peer, channelId, packet);
+    });
+
+    if (!shared.referenceCount) enet_packet_destroy(&shared);
+    return sent;
+}
+
 template <typename Comp>
 void Host::setCompression()
 {
@@ -160,6 +630,79 @@ void Host::setCompression()
     }
 }
 
+template <typename Comp>
+void Host::setPacketCompression(uint8_t channelId)
+{
+    static_assert(std::is_base_of<Compressor, Comp>::value, "Wrong class type");
+    static_assert(!std::is_same<Comp, compressor::Range>::value,
+                  "Range coder works on datagrams only");
+
+    if (!dynamic_cast<Comp*>(packetCompression_.getCompressor())) {
+        packetCompression_.setCompressor(std::make_unique<Comp>());
+    }
+    statefulCompression_.disable(channelId);
+    packetCompression_.enable(channelId);
+}
+
+// Host calling the handler directly instead of through callbacks, so the
+// compiler sees the whole path from ENet to the handler and can inline it.
+// Handler needs onConnect(Peer&, uint32_t), onReceive(Peer&, Packet&&,
+// uint8_t) and onDisconnect(size_t id, uint32_t). Callbacks set on the Host
+// base are not called when servicing through StaticHost, routes still are
+template <typename Handler>
+class StaticHost : public Host {
+public:
+    StaticHost(size_t peerCount=1, const ENetAddress* address=nullptr,
+               Handler handler=Handler{})
+        : Host(peerCount, address), delivery_{std::move(handler)}
+    { }
+    StaticHost(const Address& address, size_t peerCount,
+               Handler handler=Handler{})
+        : Host(address, peerCount), delivery_{std::move(handler)}
+    { }
+
+    Handler& getHandler() noexcept { return delivery_.handler; }
+    const Handler& getHandler() const noexcept { return delivery_.handler; }
+
+    bool receive(int limit=0) { return receiveWith(limit, delivery_); }
+    bool service(int limit=0) { return service(time::ms{0}, limit); }
+    bool service(time::ms timeout, int limit=0)
+    {
+        return serviceWith(timeout, limit, delivery_);
+    }
+    bool service(Clock::time_point deadline)
+    {
+        return serviceWith(deadline, delivery_);
+    }
+    bool poll(time::ms timeout) { return pollWith(timeout, delivery_); }
+
+private:
+    struct Delivery {
+        // moved in, a Handler& binds to what the parameter refers to
+        explicit Delivery(std::remove_reference_t<Handler>&& from)
+            : handler(static_cast<Handler&&>(from))
+        { }
+
+        Handler handler;
+
+        void connect(Peer& peer, uint32_t data)
+        {
+            handler.onConnect(peer, data);
+        }
+        void receive(Peer& peer, Packet&& packet, uint8_t channelId)
+        {
+            handler.onReceive(peer, std::move(packet), channelId);
+        }
+        void disconnect(size_t id, uint32_t data)
+        {
+            handler.onDisconnect(id, data);
+        }
+    };
+
+private:
+    Delivery delivery_;
+};
+
 } // \wenet
 
 } // \sq
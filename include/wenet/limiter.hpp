@@ -0,0 +1,86 @@
+#ifndef SQ_WENET_LIMITER_HPP
+#define SQ_WENET_LIMITER_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+// Token buckets for incoming datagrams per source IP and per source address
+// (IP and port, which is what a peer is), checked before ENet parses them.
+// Buckets live in a fixed size open addressing table where idle entries are
+// reused and the least recently seen one is evicted when a probe finds no room,
+// new buckets start with a tenth of a second worth of tokens
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Per second, 0 is unlimited
+    struct Rate {
+        uint32_t packets;
+        uint32_t bytes;
+    };
+
+    struct Limit {
+        Rate source; // all datagrams from an IP address
+        Rate peer; // datagrams from an IP address and port
+    };
+
+    struct Stats {
+        size_t droppedPackets;
+        size_t droppedBytes;
+    };
+
+public:
+    explicit RateLimiter(size_t capacity=4096);
+
+    bool isEnabled() const noexcept { return enabled_; }
+    Limit getLimit() const noexcept { return limit_; }
+    void setLimit(const Limit& limit) noexcept;
+
+    // True if the datagram is over the limit and has to be dropped
+    bool intercept(const ENetAddress& address, size_t bytes,
+                   Clock::time_point now) noexcept;
+
+    Stats getStats() const noexcept { return stats_; }
+
+private:
+    struct Bucket {
+        uint64_t key = 0; // 0 is empty
+        uint32_t seen = 0; // ms
+        float packets = 0;
+        float bytes = 0;
+    };
+
+    // Bucket of the key, keep is never evicted to make room for it
+    Bucket& find(uint64_t key, const Rate& rate, size_t bytes, uint32_t now,
+                 const Bucket* keep) noexcept;
+    // Bucket of the key with tokens added since it was last seen, nullptr
+    // if the rate is unlimited
+    Bucket* refill(uint64_t key, const Rate& rate, size_t bytes, uint32_t now,
+                   const Bucket* keep) noexcept;
+
+    static bool allows(const Bucket* bucket, const Rate& rate,
+                       size_t bytes) noexcept;
+    static void charge(Bucket* bucket, const Rate& rate,
+                       size_t bytes) noexcept;
+
+private:
+    bool enabled_ = false;
+    Limit limit_{{0, 0}, {0, 0}};
+    Clock::time_point epoch_;
+    std::vector<Bucket> buckets_;
+    Stats stats_{0, 0};
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
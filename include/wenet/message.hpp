@@ -0,0 +1,343 @@
+#ifndef SQ_WENET_MESSAGE_HPP
+#define SQ_WENET_MESSAGE_HPP
+
+#include "belks/base.hpp"
+
+#include <initializer_list>
+#include <algorithm>
+#include <cmath>
+
+#include "wenet/packet.hpp"
+
+// Field of a message schema, e.g. WENET_FIELD(&Move::x, Float<-64, 64, 12>)
+#define WENET_FIELD(member, ...) \
+    ::sq::wenet::message::Field<decltype(member), member, __VA_ARGS__>
+
+namespace sq {
+
+namespace wenet {
+
+// Bit-packed messages. A schema lists the fields of a plain struct together
+// with their codecs, each field takes only as many bits as its range needs
+// and everything is written straight into the packet data
+namespace message {
+
+class Exception : public std::runtime_error {
+public: using std::runtime_error::runtime_error;
+};
+
+namespace message_detail {
+
+// Bits needed for values from 0 up to and including range
+constexpr unsigned getBits(uint64_t range) noexcept
+{
+    return range ? 1 + getBits(range >> 1) : 0;
+}
+
+constexpr unsigned sum(std::initializer_list<unsigned> values) noexcept
+{
+    auto result = 0u;
+    for (auto value : values) result += value;
+    return result;
+}
+
+constexpr bool all(std::initializer_list<bool> values) noexcept
+{
+    for (auto value : values) if (!value) return false;
+    return true;
+}
+
+constexpr uint64_t getMask(unsigned bits) noexcept
+{
+    return bits < 64 ? (uint64_t(1) << bits) - 1 : ~uint64_t(0);
+}
+
+template <typename Pointer> struct Member;
+
+template <typename C, typename T>
+struct Member<T C::*> {
+    using Class = C;
+    using Type = T;
+};
+
+} // \message_detail
+
+// Writes bits least significant first, whole bytes go out as they fill up
+class Writer {
+public:
+    explicit Writer(span<byte> data) noexcept : data_(data.data()) { }
+
+    void write(uint64_t value, unsigned bits) noexcept
+    {
+        if (bits > 32) {
+            write(value & 0xffffffff, 32);
+            value >>= 32;
+            bits -= 32;
+        }
+
+        scratch_ |= (value & message_detail::getMask(bits)) << count_;
+        count_ += bits;
+        for (; count_ >= 8; count_ -= 8) {
+            data_[size_++] = byte(scratch_);
+            scratch_ >>= 8;
+        }
+    }
+
+    // Writes out the last partial byte, returns total bytes written
+    size_t finish() noexcept
+    {
+        if (count_) data_[size_++] = byte(scratch_);
+        scratch_ = count_ = 0;
+        return size_;
+    }
+
+private:
+    byte* data_;
+    uint64_t scratch_ = 0;
+    unsigned count_ = 0;
+    size_t size_ = 0;
+};
+
+// Reading past the end of data yields zeroes and marks the reader as failed
+class Reader {
+public:
+    explicit Reader(span<const byte> data) noexcept
+        : data_(data.data()), size_(data.size()) { }
+
+    uint64_t read(unsigned bits) noexcept
+    {
+        if (bits > 32) {
+            const auto low = read(32);
+            return low | read(bits - 32) << 32;
+        }
+
+        for (; count_ < bits; count_ += 8) {
+            if (position_ == size_) {
+                failed_ = true;
+                return 0;
+            }
+            scratch_ |= uint64_t(data_[position_++]) << count_;
+        }
+
+        const auto value = scratch_ & message_detail::getMask(bits);
+        scratch_ >>= bits;
+        count_ -= bits;
+        return value;
+    }
+
+    bool isFailed() const noexcept { return failed_; }
+
+private:
+    const byte* data_;
+    size_t size_;
+    size_t position_ = 0;
+    uint64_t scratch_ = 0;
+    unsigned count_ = 0;
+    bool failed_ = false;
+};
+
+// Integer in [Min, Max], values outside are clamped when written
+template <int64_t Min, int64_t Max>
+struct Int {
+    static_assert(Min <= Max, "Empty range");
+
+    static constexpr auto MaxBits = message_detail::getBits(
+        uint64_t(Max) - uint64_t(Min)
+    );
+
+    template <typename T>
+    static constexpr unsigned getBits(const T&) noexcept { return MaxBits; }
+
+    template <typename T>
+    static void write(Writer& writer, const T& value) noexcept
+    {
+        const auto clamped = std::min(std::max(int64_t(value), Min), Max);
+        writer.write(uint64_t(clamped) - uint64_t(Min), MaxBits);
+    }
+
+    template <typename T>
+    static bool read(Reader& reader, T& value) noexcept
+    {
+        const auto offset = reader.read(MaxBits);
+        if (offset > uint64_t(Max) - uint64_t(Min)) return false;
+        value = T(int64_t(uint64_t(Min) + offset));
+        return true;
+    }
+};
+
+// Float in [Min, Max] quantised to Bits, values outside are clamped
+template <int64_t Min, int64_t Max, unsigned Bits>
+struct Float {
+    static_assert(Min < Max, "Empty range");
+    static_assert(Bits > 0 && Bits <= 32, "Float takes 1 to 32 bits");
+
+    static constexpr auto MaxBits = Bits;
+
+    template <typename T>
+    static constexpr unsigned getBits(const T&) noexcept { return MaxBits; }
+
+    template <typename T>
+    static void write(Writer& writer, const T& value) noexcept
+    {
+        const auto clamped = std::min(std::max(double(value), double(Min)),
+                                      double(Max));
+        const auto steps = double(message_detail::getMask(Bits));
+        const auto scaled = (clamped - Min) / (Max - Min) * steps;
+        writer.write(uint64_t(std::lround(scaled)), Bits);
+    }
+
+    template <typename T>
+    static bool read(Reader& reader, T& value) noexcept
+    {
+        const auto steps = double(message_detail::getMask(Bits));
+        value = T(Min + reader.read(Bits) / steps * (Max - Min));
+        return true;
+    }
+};
+
+struct Bool {
+    static constexpr auto MaxBits = 1u;
+
+    static constexpr unsigned getBits(bool) noexcept { return MaxBits; }
+
+    static void write(Writer& writer, bool value) noexcept
+    {
+        writer.write(value, 1);
+    }
+
+    static bool read(Reader& reader, bool& value) noexcept
+    {
+        value = reader.read(1);
+        return true;
+    }
+};
+
+// Value of an optional field, only its presence bit is sent when not set
+template <typename T>
+struct Optional {
+    bool set = false;
+    T value{};
+
+    Optional() noexcept = default;
+    Optional(const T& value) noexcept : set(true), value(value) { }
+
+    explicit operator bool () const noexcept { return set; }
+    const T& operator * () const noexcept { return value; }
+    T& operator * () noexcept { return value; }
+
+    void reset() noexcept { set = false; }
+};
+
+template <typename Codec>
+struct Opt {
+    static constexpr auto MaxBits = 1 + Codec::MaxBits;
+
+    template <typename T>
+    static unsigned getBits(const Optional<T>& value) noexcept
+    {
+        return value ? MaxBits : 1;
+    }
+
+    template <typename T>
+    static void write(Writer& writer, const Optional<T>& value) noexcept
+    {
+        writer.write(value.set, 1);
+        if (value) Codec::write(writer, *value);
+    }
+
+    template <typename T>
+    static bool read(Reader& reader, Optional<T>& value) noexcept
+    {
+        value.set = reader.read(1);
+        return !value || Codec::read(reader, *value);
+    }
+};
+
+template <typename Pointer, Pointer member, typename Codec>
+struct Field {
+    using Class = typename message_detail::Member<Pointer>::Class;
+
+    static constexpr auto MaxBits = Codec::MaxBits;
+
+    static unsigned getBits(const Class& message) noexcept
+    {
+        return Codec::getBits(message.*member);
+    }
+
+    static void write(Writer& writer, const Class& message) noexcept
+    {
+        Codec::write(writer, message.*member);
+    }
+
+    static bool read(Reader& reader, Class& message) noexcept
+    {
+        return Codec::read(reader, message.*member);
+    }
+};
+
+template <typename Class, typename... Fields>
+struct Schema {
+    static_assert(message_detail::all({
+        std::is_same<Class, typename Fields::Class>::value...
+    }), "Fields belong to a different class");
+
+    static constexpr auto MaxBits = message_detail::sum({Fields::MaxBits...});
+    static constexpr size_t MaxSize = (MaxBits + 7) / 8;
+
+    static size_t getSize(const Class& message) noexcept
+    {
+        return (message_detail::sum({Fields::getBits(message)...}) + 7) / 8;
+    }
+
+    // Returns bytes written
+    static size_t write(const Class& message, span<byte> data)
+    {
+        if (size_t(data.size()) < MaxSize &&
+            size_t(data.size()) < getSize(message)) {
+            throw Exception{"Message does not fit"};
+        }
+
+        Writer writer{data};
+        (void)std::initializer_list<int>{
+            (Fields::write(writer, message), 0)...
+        };
+        return writer.finish();
+    }
+
+    // False if data is too short or holds values out of range
+    static bool read(span<const byte> data, Class& message) noexcept
+    {
+        Reader reader{data};
+        auto valid = true;
+        (void)std::initializer_list<int>{
+            (valid = valid && Fields::read(reader, message), 0)...
+        };
+        return valid && !reader.isFailed();
+    }
+
+    static Packet pack(const Class& message,
+                       Packet::Flag flag=Packet::Flag::Reliable)
+    {
+        return pack(message, belks::underlying_cast(flag));
+    }
+
+    static Packet pack(const Class& message, Packet::Flags flags)
+    {
+        Packet packet{getSize(message), flags};
+        write(message, packet.getData());
+        return packet;
+    }
+
+    static bool unpack(const Packet& packet, Class& message) noexcept
+    {
+        return read(packet.getData(), message);
+    }
+};
+
+} // \message
+
+} // \wenet
+
+} // \sq
+
+#endif
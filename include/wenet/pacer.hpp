@@ -0,0 +1,81 @@
+#ifndef SQ_WENET_PACER_HPP
+#define SQ_WENET_PACER_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <vector>
+
+#include "wenet/units.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+// Token buckets per peer and for the whole host, limiting how many bytes the
+// channel scheduler may hand over to ENet at a time, so queued packets leave
+// spread over time at the target rate instead of in one burst
+class Pacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        speed::bs peer; // bytes per second to every peer, 0 is unlimited
+        speed::bs host; // bytes per second to all peers, 0 is unlimited
+        time::us burst; // time at the rate a full bucket lasts
+    };
+
+    // Time between consecutive hand overs to ENet
+    struct Gaps {
+        time::us last;
+        time::us average; // moving average
+    };
+
+public:
+    explicit Pacer(size_t peerCount);
+
+    bool isEnabled() const noexcept { return settings_.peer || settings_.host; }
+    const Settings& getSettings() const noexcept { return settings_; }
+    void setSettings(const Settings& settings) noexcept;
+
+    void reset(const ENetPeer& peer) noexcept;
+
+    // Refills the buckets, returns number of bytes that can be handed over
+    // to ENet for the peer right now
+    size_t update(const ENetPeer& peer, Clock::time_point now) noexcept;
+
+    // Bytes handed over to ENet after update()
+    void onSent(const ENetPeer& peer, size_t bytes,
+                Clock::time_point now) noexcept;
+
+    Gaps getGaps() const noexcept { return toGaps(host_); }
+    Gaps getGaps(const ENetPeer& peer) const noexcept;
+
+private:
+    struct Bucket {
+        double tokens = 0;
+        Clock::time_point refill;
+        Clock::time_point sent;
+        double last = 0; // us
+        double average = 0; // us
+    };
+
+    void refill(Bucket& bucket, speed::bs rate, size_t mtu,
+                Clock::time_point now) const noexcept;
+    static void take(Bucket& bucket, size_t bytes,
+                     Clock::time_point now) noexcept;
+    static Gaps toGaps(const Bucket& bucket) noexcept;
+
+private:
+    Settings settings_{0, 0, time::us{2000}};
+    std::vector<Bucket> slots_;
+    Bucket host_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
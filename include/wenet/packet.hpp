@@ -7,6 +7,10 @@
 #include <enet/enet.h>
 
 #include <memory>
+#include <chrono>
+
+#include "wenet/units.hpp"
+#include "wenet/buffer.hpp"
 
 namespace sq {
 
@@ -16,6 +20,8 @@ class Packet {
     struct Deleter { void operator () (ENetPacket* packet) const noexcept; };
 
 public:
+    using Clock = std::chrono::steady_clock;
+
     enum class Flag : uint32_t {
         Reliable = ENET_PACKET_FLAG_RELIABLE,
         Unsequenced = ENET_PACKET_FLAG_UNSEQUENCED,
@@ -38,14 +44,15 @@ public:
     public: using Exception::Exception;
     };
 
-    using FreeCallback = std::function<void (Packet&& packet)>;
-    
 public:
     Packet() noexcept = default;
     Packet(span<const byte> data, Flag flag=Flag::Reliable);
     Packet(span<const byte> data, Flags flags);
     Packet(size_t size, Flag flag=Flag::Reliable);
     Packet(size_t size, Flags flags) noexcept;
+    // Unmanaged packet referencing the buffer until destroyed
+    Packet(const SharedBuffer& buffer, Flag flag=Flag::Reliable);
+    Packet(const SharedBuffer& buffer, Flags flags);
     Packet(ENetPacket& packet, bool manage=true) noexcept;
 
     operator ENetPacket* () const noexcept { return packet_; }
@@ -54,14 +61,27 @@ public:
 
     const Packet& operator << (span<const byte> data) const;
 
-    void onDestroy(const FreeCallback& callback) const noexcept;
-
+    Flags getFlags() const noexcept { return packet_->flags; }
     void setFlags(Flags flags) const;
     void resize(size_t size) const;
 
     span<byte> getData() const noexcept;
     size_t getSize() const noexcept { return packet_->dataLength; }
 
+    // Unreliable packet still queued after the deadline is dropped instead
+    // of sent, reliable ones never expire. Default time point is no deadline
+
+    Clock::time_point getDeadline() const noexcept { return deadline_; }
+    void setDeadline(Clock::time_point deadline) noexcept;
+    void setTtl(time::ms ttl) noexcept;
+
+    // Key of the state the packet carries, on a state channel it replaces
+    // the queued packet with the same key, see Host::enableStateChannel
+
+    static constexpr uint64_t NoKey = uint64_t(-1);
+    uint64_t getKey() const noexcept { return key_; }
+    void setKey(uint64_t key) noexcept { key_ = key; }
+
     void releaseOwnership() noexcept { packetOwned_.release(); }
 
     bool isInit() const noexcept { return packet_; }
@@ -75,6 +95,8 @@ private:
 private:
     ENetPacket* packet_ = nullptr;
     std::unique_ptr<ENetPacket, Deleter> packetOwned_;
+    Clock::time_point deadline_;
+    uint64_t key_ = NoKey;
 };
 
 constexpr auto operator | (Packet::Flag flag1, Packet::Flag flag2) noexcept
@@ -8,6 +8,7 @@
 #include "wenet/units.hpp"
 #include "wenet/address.hpp"
 #include "wenet/packet.hpp"
+#include "wenet/pacer.hpp"
 #include "convw/convw.hpp"
 
 namespace sq {
@@ -30,6 +31,11 @@ public:
         time::ms maximum;
     };
 
+    struct Queue {
+        size_t bytes;
+        size_t packets;
+    };
+
     enum class State {
         Disconnected = ENET_PEER_STATE_DISCONNECTED,
         Connecting = ENET_PEER_STATE_CONNECTING,
@@ -73,10 +79,25 @@ public:
 
     void receive(Callback callback) const noexcept;
 
-    // Send
+    // Send, false if the packet was not queued
+
+    bool send(Packet& packet, uint8_t channelId=0) const noexcept;
+    bool send(Packet&& packet, uint8_t channelId=0) const noexcept;
+    // Sets packet's deadline ttl from now, see Packet::setDeadline
+    bool send(Packet& packet, uint8_t channelId, time::ms ttl) const noexcept;
+    bool send(Packet&& packet, uint8_t channelId, time::ms ttl) const noexcept;
+
+    // Streams file over host's stream channel, returns stream id
+
+    uint32_t sendStream(cstring_span<> path, span<const byte> info={}) const;
 
-    void send(Packet& packet, uint8_t channelId=0) const noexcept;
-    void send(Packet&& packet, uint8_t channelId=0) const noexcept;
+    // Queue (packets queued but not yet sent)
+
+    Queue getQueue() const noexcept;
+    Queue getQueue(uint8_t channelId) const noexcept;
+    size_t getDroppedPackets() const noexcept;
+    size_t getExpiredPackets() const noexcept;
+    size_t getExpiredPackets(uint8_t channelId) const noexcept;
 
     // Throttle
 
@@ -99,6 +120,16 @@ public:
     time::ms getRoundTripTime() const noexcept;
     uint32_t getPacketLoss() const noexcept;
 
+    // Congestion control estimates (0 unless enabled on host)
+
+    speed::bs getEstimatedBandwidth() const noexcept;
+    speed::bs getPacingRate() const noexcept;
+    time::ms getMinRoundTripTime() const noexcept;
+
+    // Send pacing (0 unless enabled on host)
+
+    Pacer::Gaps getPacingGaps() const noexcept;
+
 private:
     Host* host_;
     ENetPeer* peer_ = nullptr;
@@ -0,0 +1,76 @@
+#ifndef SQ_WENET_POOL_HPP
+#define SQ_WENET_POOL_HPP
+
+#include "belks/base.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace sq {
+
+namespace wenet {
+
+// Parallel for over an index range. Every thread starts with an equal slice
+// and takes indices from its front, a thread that runs out steals the back
+// half of the largest slice left, so uneven work still keeps all of them busy.
+// The calling thread works too and run() returns once all indices are done
+class WorkPool {
+public:
+    using Task = std::function<void (size_t)>;
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    // One thread per core, including the calling one
+    WorkPool();
+    // Threads in addition to the calling one
+    explicit WorkPool(size_t threads);
+    WorkPool(const WorkPool&) = delete;
+    ~WorkPool() noexcept;
+
+    size_t getThreadCount() const noexcept { return threads_.size(); }
+
+    // Calls task for every index in [0, count), exception thrown by a task is
+    // rethrown once all threads have stopped (indices are 32 bit)
+    void run(size_t count, const Task& task);
+
+private:
+    // Begin and end of a slice packed together, so both change atomically.
+    // Padded rather than aligned, C++14 new ignores extended alignment
+    struct Slice {
+        std::atomic<uint64_t> bounds{0};
+        byte padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    void loop(size_t worker);
+    void work(size_t worker) noexcept;
+    bool take(size_t worker, size_t& index) noexcept;
+    bool steal(size_t worker) noexcept;
+
+private:
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Slice[]> slices_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const Task* task_ = nullptr;
+    size_t generation_ = 0;
+    size_t working_ = 0; // threads not finished with the current run
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
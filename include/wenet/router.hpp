@@ -0,0 +1,137 @@
+#ifndef SQ_WENET_ROUTER_HPP
+#define SQ_WENET_ROUTER_HPP
+
+#include "belks/base.hpp"
+
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+#include "wenet/packet.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+class Peer;
+
+// Routes received packets to handlers by channel and message id, the first
+// byte of the packet. Each channel with routes gets a flat table of 256 plain
+// function pointers, so dispatch is two loads and an indirect call
+class Router {
+public:
+    using Handler = void (*)(void* context, Peer& peer, Packet&& packet);
+
+public:
+    void add(uint8_t channelId, uint8_t messageId, Handler handler,
+             void* context=nullptr);
+    void remove(uint8_t channelId, uint8_t messageId) noexcept;
+
+    // Handler object called as handler(peer, std::move(packet)), it has to
+    // outlive the route
+    template <typename T>
+    void add(uint8_t channelId, uint8_t messageId, T& handler);
+
+    // Packet is moved to the handler if there is one, false otherwise (and
+    // for empty packets)
+    bool dispatch(Peer& peer, Packet& packet, uint8_t channelId) const;
+
+private:
+    struct Entry {
+        Handler handler;
+        void* context;
+    };
+    using Table = std::array<Entry, 256>;
+
+private:
+    std::array<std::unique_ptr<Table>, 256> tables_;
+};
+
+template <typename T>
+void Router::add(uint8_t channelId, uint8_t messageId, T& handler)
+{
+    add(channelId, messageId, [](void* context, Peer& peer, Packet&& packet) {
+        (*static_cast<T*>(context))(peer, std::move(packet));
+    }, &handler);
+}
+
+// Route known at compile time, see StaticRouter
+template <uint8_t Channel, uint8_t Message,
+          void (*Handle)(Peer& peer, Packet&& packet)>
+struct Route {
+    static constexpr auto ChannelId = Channel;
+    static constexpr auto MessageId = Message;
+    static constexpr auto Handler = Handle;
+};
+
+namespace router_detail {
+
+using Handler = void (*)(Peer& peer, Packet&& packet);
+
+template <typename... Routes>
+constexpr Handler find(size_t key) noexcept
+{
+    // leading dummy keeps the arrays valid when there are no routes
+    const size_t keys[] = {
+        0, (Routes::ChannelId * 256u + Routes::MessageId)...
+    };
+    const Handler handlers[] = {nullptr, Routes::Handler...};
+    for (auto i = size_t(1); i < sizeof(keys) / sizeof(*keys); ++i) {
+        if (keys[i] == key) return handlers[i];
+    }
+    return nullptr;
+}
+
+constexpr size_t max(std::initializer_list<size_t> values) noexcept
+{
+    auto result = size_t(0);
+    for (auto value : values) if (value > result) result = value;
+    return result;
+}
+
+} // \router_detail
+
+// Router with routes fixed at compile time, the whole table is a constant
+template <typename... Routes>
+class StaticRouter {
+    using Handler = router_detail::Handler;
+
+    static constexpr size_t Channels = 1 + router_detail::max({
+        size_t(Routes::ChannelId)...
+    });
+
+    template <size_t... Keys>
+    static constexpr std::array<Handler, sizeof...(Keys)> makeTable(
+        std::index_sequence<Keys...>) noexcept
+    {
+        return {{router_detail::find<Routes...>(Keys)...}};
+    }
+
+public:
+    static bool dispatch(Peer& peer, Packet& packet, uint8_t channelId)
+    {
+        if (channelId >= Channels || !packet.getSize()) return false;
+
+        const auto handler = Table[channelId * 256u + packet.getData()[0]];
+        if (!handler) return false;
+        handler(peer, std::move(packet));
+        return true;
+    }
+
+private:
+    static constexpr std::array<Handler, Channels * 256> Table = makeTable(
+        std::make_index_sequence<Channels * 256>{}
+    );
+};
+
+template <typename... Routes>
+constexpr std::array<router_detail::Handler,
+                     StaticRouter<Routes...>::Channels * 256>
+    StaticRouter<Routes...>::Table;
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef SQ_WENET_SCHEDULER_HPP
+#define SQ_WENET_SCHEDULER_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <vector>
+#include <array>
+#include <bitset>
+#include <unordered_map>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+// Holds outgoing packets per peer and channel in front of ENet and releases
+// them in channel priority order, no more than the peer's window allows
+class ChannelScheduler {
+public:
+    struct Priority {
+        uint8_t level; // higher levels are always served first
+        uint32_t weight; // share of bandwidth within the same level
+    };
+
+    struct Count {
+        size_t bytes;
+        size_t packets;
+    };
+
+public:
+    explicit ChannelScheduler(size_t peerCount);
+    ChannelScheduler(const ChannelScheduler&) = delete;
+    ~ChannelScheduler() noexcept;
+
+    bool isEnabled() const noexcept { return enabled_; }
+    void enable() noexcept { enabled_ = true; }
+
+    Priority getPriority(uint8_t channelId) const noexcept;
+    void setPriority(uint8_t channelId, const Priority& priority) noexcept;
+
+    // Keyed channels keep one queued packet per key, the latest one
+    bool isKeyed(uint8_t channelId) const noexcept { return keyed_[channelId]; }
+    void setKeyed(uint8_t channelId, bool keyed) noexcept;
+
+    // Takes a reference to the packet until it is handed over to ENet
+    void push(ENetPeer& peer, uint8_t channelId, ENetPacket& packet);
+    // On a keyed channel the packet takes the place of the queued one with
+    // the same key if there is one, returns size of the replaced packet
+    size_t push(ENetPeer& peer, uint8_t channelId, ENetPacket& packet,
+                uint64_t key);
+
+    // Hands queued packets over to ENet while limit is not exhausted (the
+    // last packet may overshoot it), returns number of bytes handed over.
+    // Reliable gets how many of them ENet sends reliably, refused the number
+    // of packets ENet would not take, they are released and not counted
+    size_t drain(ENetPeer& peer, size_t limit=size_t(-1)) noexcept;
+    size_t drain(ENetPeer& peer, size_t limit, size_t& reliable,
+                 size_t& refused) noexcept;
+
+    // Releases everything queued for the peer
+    void clear(ENetPeer& peer) noexcept;
+
+    // Removes the oldest queued unreliable packet, returns its size
+    size_t dropOldestUnreliable(ENetPeer& peer) noexcept;
+
+    // Removes every queued unreliable packet filter accepts, removed gets
+    // the channel of each one, returns number of bytes removed
+    template <typename Filter, typename Removed>
+    size_t dropUnreliable(ENetPeer& peer, Filter filter, Removed removed);
+
+    Count count(const ENetPeer& peer) const noexcept;
+    Count count(const ENetPeer& peer, uint8_t channelId) const noexcept;
+
+private:
+    struct Entry {
+        ENetPacket* packet;
+        uint64_t sequence;
+    };
+
+    struct Lane {
+        std::vector<Entry> entries;
+        size_t head = 0;
+        size_t deficit = 0;
+        size_t bytes = 0;
+        // sequence of the entry last pushed with the key, it may be gone
+        std::unordered_map<uint64_t, uint64_t> keys;
+
+        bool empty() const noexcept { return head == entries.size(); }
+        Entry& front() noexcept { return entries[head]; }
+        ENetPacket& pop() noexcept;
+        Entry* find(uint64_t sequence) noexcept;
+        void reset() noexcept;
+    };
+
+    struct Slot {
+        std::vector<Lane> lanes;
+        size_t packets = 0;
+    };
+
+    Slot& getSlot(const ENetPeer& peer) noexcept;
+    const Slot& getSlot(const ENetPeer& peer) const noexcept;
+
+    static void release(ENetPacket& packet) noexcept;
+
+private:
+    std::array<Priority, 256> priorities_;
+    std::bitset<256> keyed_;
+    std::vector<Slot> slots_;
+    uint64_t sequence_ = 0;
+    bool enabled_ = false;
+};
+
+template <typename Filter, typename Removed>
+size_t ChannelScheduler::dropUnreliable(ENetPeer& peer, Filter filter,
+                                        Removed removed)
+{
+    auto& slot = getSlot(peer);
+
+    size_t bytes = 0;
+    for (auto channelId = 0u; channelId < slot.lanes.size(); ++channelId) {
+        auto& lane = slot.lanes[channelId];
+        const auto end = std::remove_if(
+            lane.entries.begin() + lane.head, lane.entries.end(),
+            [&](const Entry& entry) {
+                auto& packet = *entry.packet;
+                if (packet.flags & ENET_PACKET_FLAG_RELIABLE) return false;
+                if (!filter(packet)) return false;
+
+                removed(uint8_t(channelId));
+                lane.bytes -= packet.dataLength;
+                bytes += packet.dataLength;
+                slot.packets--;
+                release(packet);
+                return true;
+            }
+        );
+        lane.entries.erase(end, lane.entries.end());
+        if (lane.empty()) lane.reset();
+    }
+    return bytes;
+}
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef SQ_WENET_STREAM_HPP
+#define SQ_WENET_STREAM_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <memory>
+#include <vector>
+
+#include "wenet/peer.hpp"
+#include "convw/convw.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+class Host;
+
+class MappedFile {
+public:
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    // Maps existing file for reading
+    explicit MappedFile(cstring_span<> path);
+    // Creates (or truncates) file of given size and maps it for writing
+    MappedFile(cstring_span<> path, size_t size);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+    ~MappedFile() noexcept;
+
+    span<byte> getData() const noexcept;
+    size_t getSize() const noexcept { return size_; }
+
+private:
+    void map(int protection, int flags);
+
+private:
+    int fd_ = -1;
+    byte* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct StreamProgress {
+    uint32_t id;
+    size_t done;
+    size_t total;
+};
+
+// Stream announced by a peer, chunks are discarded unless it is accepted
+class IncomingStream {
+    friend class Streams;
+
+public:
+    uint32_t getId() const noexcept { return id_; }
+    size_t getSize() const noexcept { return size_; }
+    span<const byte> getInfo() const noexcept
+    {
+        return {info_.data(), std::ptrdiff_t(info_.size())};
+    }
+
+    // Destination has to stay valid until the stream is received
+    void accept(span<byte> destination);
+    void accept(cstring_span<> path);
+
+    bool isAccepted() const noexcept { return destination_.data(); }
+
+private:
+    bool active_ = false;
+    uint32_t id_ = 0;
+    size_t size_ = 0;
+    size_t received_ = 0;
+    std::vector<byte> info_;
+    span<byte> destination_;
+    std::unique_ptr<MappedFile> file_;
+};
+
+// Sends files as a series of chunks pointing straight into a memory mapping
+// over a dedicated reliable channel. Chunks are released by ENet once
+// acknowledged, which moves the window forward
+class Streams {
+    struct Outgoing {
+        Outgoing(ENetPeer& peer, uint32_t id, cstring_span<> path,
+                 span<const byte> info)
+            : peer(&peer), id(id), file(path), info(info.begin(), info.end())
+        { }
+
+        ENetPeer* peer;
+        uint32_t id;
+        MappedFile file;
+        std::vector<byte> info;
+        bool begun = false;
+        bool aborted = false;
+        size_t sent = 0;
+        size_t acked = 0;
+        size_t reported = 0;
+        size_t outstanding = 0; // chunks not yet released by ENet
+    };
+
+public:
+    using BeginCallback = convw::Convw<void (Peer&, IncomingStream&)>;
+    using ProgressCallback = convw::Convw<void (Peer&, const StreamProgress&)>;
+
+    struct Window {
+        size_t chunkSize;
+        size_t chunks; // unacknowledged chunks in flight
+    };
+
+    class Exception : public std::runtime_error {
+    public: using std::runtime_error::runtime_error;
+    };
+
+public:
+    Streams(Host& host, size_t peerCount);
+    Streams(const Streams&) = delete;
+    ~Streams() noexcept;
+
+    bool isEnabled() const noexcept { return enabled_; }
+    uint8_t getChannel() const noexcept { return channelId_; }
+    void setChannel(uint8_t channelId) noexcept;
+
+    Window getWindow() const noexcept { return window_; }
+    void setWindow(const Window& window) noexcept;
+
+    void onBegin(BeginCallback callback) noexcept;
+    void onSent(ProgressCallback callback) noexcept;
+    void onReceived(ProgressCallback callback) noexcept;
+
+    uint32_t send(ENetPeer& peer, cstring_span<> path, span<const byte> info);
+
+    // Queues chunks of outgoing streams and reports their progress
+    void pump();
+
+    void receive(ENetPeer& peer, const Packet& packet);
+
+    // Peer was disconnected or reset
+    void reset(ENetPeer& peer) noexcept;
+
+private:
+    bool begin(Outgoing& stream);
+    bool sendChunk(Outgoing& stream);
+
+    IncomingStream& getIncoming(const ENetPeer& peer) noexcept;
+
+    static void ENET_CALLBACK onChunkFree(ENetPacket* packet);
+
+private:
+    Host* host_;
+    BeginCallback cbBegin_;
+    ProgressCallback cbSent_;
+    ProgressCallback cbReceived_;
+
+    bool enabled_ = false;
+    uint8_t channelId_ = 0;
+    Window window_{16 * 1024, 16};
+    uint32_t nextId_ = 0;
+
+    std::vector<std::unique_ptr<Outgoing>> outgoing_;
+    std::vector<IncomingStream> incoming_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
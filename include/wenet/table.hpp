@@ -0,0 +1,70 @@
+#ifndef SQ_WENET_TABLE_HPP
+#define SQ_WENET_TABLE_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+#include <vector>
+#include <array>
+
+namespace sq {
+
+namespace wenet {
+
+// Copy of the per peer fields that get scanned for the whole population, kept
+// as one array per field indexed by ENet peer slot. ENetPeer is large, so
+// reading a field of every peer misses cache on each of them, while a column
+// of 4096 peers fits in 16KB and scans branch free
+class PeerTable {
+public:
+    enum class Metric {
+        RoundTripTime, // ms
+        PacketLoss, // ENET_PEER_PACKET_LOSS_SCALE is 100%
+        IncomingBandwidth, // bytes per second, 0 is unlimited
+        OutgoingBandwidth, // bytes per second, 0 is unlimited
+        Count
+    };
+
+    using Slots = std::vector<uint32_t>;
+
+public:
+    explicit PeerTable(size_t peerCount);
+
+    bool isEnabled() const noexcept { return enabled_; }
+    void setEnabled(bool enabled) noexcept { enabled_ = enabled; }
+
+    // Copies fields of all peers of the host
+    void refresh(const ENetHost& host) noexcept;
+
+    // Only managed peers (those with a Peer on host) are found by queries
+    void setManaged(size_t slot, bool managed) noexcept;
+
+    size_t getSize() const noexcept { return states_.size(); }
+
+    // Columns, as of the last refresh
+    span<const uint8_t> getStates() const noexcept;
+    span<const uint32_t> get(Metric metric) const noexcept;
+
+    // Slots of connected peers with metric above or below the threshold,
+    // replace the contents of slots
+    void findAbove(Metric metric, uint32_t threshold, Slots& slots) const;
+    void findBelow(Metric metric, uint32_t threshold, Slots& slots) const;
+    size_t countAbove(Metric metric, uint32_t threshold) const noexcept;
+
+private:
+    std::vector<uint32_t>& getColumn(Metric metric) noexcept;
+
+private:
+    bool enabled_ = false;
+    std::vector<uint8_t> states_;
+    std::vector<uint8_t> managed_;
+    std::vector<uint8_t> active_; // connected and managed
+    std::array<std::vector<uint32_t>, size_t(Metric::Count)> metrics_;
+};
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -12,6 +12,7 @@ namespace wenet {
 namespace time {
 
 using ms = std::chrono::duration<uint32_t, std::milli>;
+using us = std::chrono::duration<uint32_t, std::micro>;
 
 } // \time
 
@@ -26,6 +27,11 @@ constexpr time::ms operator "" _ms(unsigned long long ms)
     return time::ms{ms};
 }
 
+constexpr time::us operator "" _us(unsigned long long us)
+{
+    return time::us{us};
+}
+
 } // \wenet
 
 } // \sq
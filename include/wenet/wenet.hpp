@@ -7,6 +7,7 @@
 #include "address.hpp"
 #include "compressor.hpp"
 #include "packet.hpp"
+#include "message.hpp"
 #include "peer.hpp"
 #include "host.hpp"
 
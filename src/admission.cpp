@@ -0,0 +1,206 @@
+#include "wenet/admission.hpp"
+
+#include <random>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr byte ChallengeMagic[] = {'W', 'N', 'C', '?'};
+constexpr byte EchoMagic[] = {'W', 'N', 'C', '!'};
+constexpr auto MagicSize = 4u;
+constexpr auto MessageSize = MagicSize + 8u; // magic and cookie
+
+constexpr auto CookieLifetime = 5s; // cookie of the previous slot is valid too
+constexpr auto TicketLifetime = 10s; // to get connection through after echo
+
+uint64_t rotate(uint64_t value, int bits) noexcept
+{
+    return value << bits | value >> (64 - bits);
+}
+
+// SipHash-2-4 of a 16 byte message, keyed hash meant for exactly this
+uint64_t sipHash(const std::array<uint64_t, 2>& key, uint64_t message0,
+                 uint64_t message1) noexcept
+{
+    uint64_t v0 = 0x736f6d6570736575ull ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dull ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ull ^ key[0];
+    uint64_t v3 = 0x7465646279746573ull ^ key[1];
+
+    const auto round = [&] {
+        v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+        v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+    };
+
+    for (auto message : {message0, message1, uint64_t(16) << 56}) {
+        v3 ^= message;
+        round(); round();
+        v0 ^= message;
+    }
+
+    v2 ^= 0xff;
+    round(); round(); round(); round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+bool operator == (const ENetAddress& lhs, const ENetAddress& rhs) noexcept
+{
+    return lhs.host == rhs.host && lhs.port == rhs.port;
+}
+
+bool isFirstContact(span<const byte> data) noexcept
+{
+    if (data.size() < 2) return false;
+    const auto peerId = uint16_t(data[0] << 8 | data[1]); // network order
+    const auto mask = ENET_PROTOCOL_HEADER_FLAG_MASK |
+                      ENET_PROTOCOL_HEADER_SESSION_MASK;
+    return (peerId & ~mask) == ENET_PROTOCOL_MAXIMUM_PEER_ID;
+}
+
+bool isMessage(span<const byte> data, const byte (&magic)[MagicSize]) noexcept
+{
+    if (data.size() != MessageSize) return false;
+    return std::equal(std::begin(magic), std::end(magic), data.begin());
+}
+
+void sendMessage(ENetHost& host, const byte (&magic)[MagicSize],
+                 uint64_t cookie) noexcept
+{
+    byte message[MessageSize];
+    std::copy(std::begin(magic), std::end(magic), message);
+    for (auto i = 0u; i < 8; ++i) {
+        message[MagicSize + i] = byte(cookie >> i * 8);
+    }
+
+    ENetBuffer buffer{message, sizeof(message)};
+    enet_socket_send(host.socket, &host.receivedAddress, &buffer, 1);
+}
+
+uint64_t readCookie(span<const byte> data) noexcept
+{
+    auto cookie = uint64_t(0);
+    for (auto i = 0u; i < 8; ++i) {
+        cookie |= uint64_t(data[MagicSize + i]) << i * 8;
+    }
+    return cookie;
+}
+
+// The connect command went out before the cookie came back and was dropped
+// by the other side, ENet would resend it only once it times out (a second or
+// more before round trip time is known). Its sent commands are made to look
+// timed out now, so the next enet_protocol_check_timeouts() resends them just
+// as ENet itself would, doubling their timeout and counting a lost packet.
+// Relies on ENet internals: sentTime and roundTripTimeout of the commands and
+// nextTimeout of the peer, which gates the check
+void resendNow(ENetHost& host, ENetPeer& peer) noexcept
+{
+    auto& commands = peer.sentReliableCommands;
+    if (enet_list_empty(&commands)) return;
+
+    for (auto node = enet_list_begin(&commands);
+         node != enet_list_end(&commands); node = enet_list_next(node)) {
+        auto& command = *reinterpret_cast<ENetOutgoingCommand*>(node);
+        command.sentTime = host.serviceTime - command.roundTripTimeout;
+    }
+    peer.nextTimeout = host.serviceTime;
+}
+
+uint64_t getSlot(Admission::Clock::time_point now) noexcept
+{
+    return uint64_t(now.time_since_epoch() / CookieLifetime);
+}
+
+} // \anonymous
+
+Admission::Admission()
+{
+    std::random_device random;
+    for (auto& key : key_) key = uint64_t(random()) << 32 | random();
+}
+
+bool Admission::intercept(ENetHost& host, Clock::time_point now) noexcept
+{
+    if (!enabled_) return false;
+
+    const auto data = span<const byte>{
+        host.receivedData, std::ptrdiff_t(host.receivedDataLength)
+    };
+
+    if (isMessage(data, ChallengeMagic)) answer(host, data);
+    else if (isMessage(data, EchoMagic)) verify(host, data, now);
+    else if (isFirstContact(data)) {
+        auto& ticket = getTicket(host.receivedAddress);
+        if (ticket.address == host.receivedAddress && now < ticket.expiry) {
+            return false; // cookie has been echoed, let ENet connect
+        }
+        challenge(host, now);
+    }
+    else return false;
+
+    return true;
+}
+
+uint64_t Admission::getCookie(const ENetAddress& address,
+                              uint64_t slot) const noexcept
+{
+    return sipHash(key_, uint64_t(address.host) << 16 | address.port, slot);
+}
+
+Admission::Ticket& Admission::getTicket(const ENetAddress& address) noexcept
+{
+    const auto hash = (uint64_t(address.host) << 16 | address.port) *
+                      0x9e3779b97f4a7c15ull;
+    return tickets_[hash >> 56];
+}
+
+void Admission::challenge(ENetHost& host, Clock::time_point now) noexcept
+{
+    // no larger than connect datagram, so it cannot be used for amplification
+    const auto cookie = getCookie(host.receivedAddress, getSlot(now));
+    sendMessage(host, ChallengeMagic, cookie);
+    stats_.challenged++;
+}
+
+void Admission::verify(ENetHost& host, span<const byte> data,
+                       Clock::time_point now) noexcept
+{
+    const auto& address = host.receivedAddress;
+    const auto cookie = readCookie(data);
+    const auto slot = getSlot(now);
+
+    if (cookie != getCookie(address, slot) &&
+        cookie != getCookie(address, slot - 1)) {
+        stats_.rejected++;
+        return;
+    }
+
+    getTicket(address) = {address, now + TicketLifetime};
+    stats_.admitted++;
+}
+
+void Admission::answer(ENetHost& host, span<const byte> data) noexcept
+{
+    // only hosts being connected to are answered, so nobody can use this
+    // host to send echoes elsewhere
+    auto peers = span<ENetPeer>{host.peers, std::ptrdiff_t(host.peerCount)};
+    auto peer = std::find_if(peers.begin(), peers.end(), [&](ENetPeer& peer) {
+        return peer.state == ENET_PEER_STATE_CONNECTING &&
+               peer.address == host.receivedAddress;
+    });
+    if (peer == peers.end()) return;
+
+    sendMessage(host, EchoMagic, readCookie(data));
+    resendNow(host, *peer);
+}
+
+} // \wenet
+
+} // \sq
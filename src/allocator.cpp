@@ -0,0 +1,328 @@
+#include "wenet/allocator.hpp"
+
+#include <enet/enet.h>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+constexpr size_t Classes[] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+    3072, 4096, 6144, 8192, 12288, Allocator::MaxSmall
+};
+constexpr auto ClassCount = sizeof(Classes) / sizeof(*Classes);
+constexpr auto Big = uint32_t(ClassCount); // class of blocks from malloc
+
+constexpr auto Batch = size_t(32); // blocks moved to or from the pool at once
+constexpr auto CacheLimit = 2 * Batch; // per class and thread
+constexpr auto HugePage = size_t(1) << 21;
+constexpr auto MinChunk = size_t(1) << 16;
+
+// In front of every block, keeps the block 16 byte aligned
+struct Header {
+    uint32_t sizeClass; // set once when the block is carved
+    uint32_t unused;
+    size_t size; // requested, for the stats
+};
+static_assert(sizeof(Header) == 16, "Header breaks alignment");
+
+// Free block, the link lives where the data was
+struct Block {
+    Block* next;
+};
+
+using Lists = std::array<Block*, ClassCount>;
+using Counts = std::array<size_t, ClassCount>;
+
+struct Pool {
+    std::mutex mutex;
+    Lists free{};
+    byte* chunk = nullptr;
+    size_t left = 0; // bytes of the chunk not carved yet
+    Allocator::Settings settings{false, 1u << 21};
+    bool installed = false;
+
+    std::atomic<size_t> live{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<size_t> reserved{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+};
+
+// Never destroyed, ENet may free blocks during static destruction
+Pool& getPool() noexcept
+{
+    static auto pool = new Pool;
+    return *pool;
+}
+
+Header& getHeader(void* memory) noexcept
+{
+    return *reinterpret_cast<Header*>(static_cast<byte*>(memory) -
+                                      sizeof(Header));
+}
+
+uint32_t getClass(size_t size) noexcept
+{
+    auto index = uint32_t(0);
+    while (index < ClassCount && Classes[index] < size) ++index;
+    return index;
+}
+
+byte* reserve(size_t size, bool hugePages) noexcept
+{
+    // hugepages are only used for 2 MiB aligned ranges, over-map and trim
+    const auto extra = hugePages ? HugePage : 0;
+    auto memory = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+
+    auto begin = static_cast<byte*>(memory);
+    if (hugePages) {
+        const auto address = reinterpret_cast<uintptr_t>(begin);
+        const auto offset = (HugePage - address % HugePage) % HugePage;
+        if (offset) munmap(begin, offset);
+        if (extra - offset) munmap(begin + offset + size, extra - offset);
+        begin += offset;
+#ifdef MADV_HUGEPAGE
+        madvise(begin, size, MADV_HUGEPAGE);
+#endif
+    }
+    return begin;
+}
+
+// Moves up to count blocks of the class from the pool, carving new ones when
+// it has none, returns the number of blocks moved
+size_t take(Pool& pool, uint32_t index, Block*& list, size_t count) noexcept
+{
+    std::lock_guard<std::mutex> lock{pool.mutex};
+
+    auto moved = size_t(0);
+    auto& free = pool.free[index];
+    for (; moved < count && free; ++moved) {
+        auto block = free;
+        free = block->next;
+        block->next = list;
+        list = block;
+    }
+    if (moved) return moved;
+
+    const auto stride = sizeof(Header) + Classes[index];
+    for (; moved < count; ++moved) {
+        if (pool.left < stride) {
+            // the tail of the old chunk is left unused
+            auto size = std::max(pool.settings.chunkSize, MinChunk);
+            if (pool.settings.hugePages) {
+                size = (size + HugePage - 1) / HugePage * HugePage;
+            }
+            const auto chunk = reserve(size, pool.settings.hugePages);
+            if (!chunk) break;
+            pool.chunk = chunk;
+            pool.left = size;
+            pool.reserved.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        auto& header = *reinterpret_cast<Header*>(pool.chunk);
+        header.sizeClass = index;
+        auto block = reinterpret_cast<Block*>(pool.chunk + sizeof(Header));
+        block->next = list;
+        list = block;
+        pool.chunk += stride;
+        pool.left -= stride;
+    }
+    return moved;
+}
+
+void give(Pool& pool, uint32_t index, Block*& list, size_t count) noexcept
+{
+    std::lock_guard<std::mutex> lock{pool.mutex};
+
+    auto& free = pool.free[index];
+    for (auto i = size_t(0); i < count && list; ++i) {
+        auto block = list;
+        list = block->next;
+        block->next = free;
+        free = block;
+    }
+}
+
+thread_local bool cacheDestroyed = false;
+
+// Free blocks of the thread, handed back to the pool when it exits
+struct Cache {
+    Lists free{};
+    Counts counts{};
+
+    ~Cache() noexcept
+    {
+        auto& pool = getPool();
+        for (auto index = uint32_t(0); index < ClassCount; ++index) {
+            give(pool, index, free[index], counts[index]);
+        }
+        cacheDestroyed = true;
+    }
+};
+
+thread_local Cache cache;
+
+void* allocateSmall(Pool& pool, uint32_t index) noexcept
+{
+    // thread exit destroys the cache before later thread locals are done
+    if (cacheDestroyed) {
+        Block* block = nullptr;
+        return take(pool, index, block, 1) ? block : nullptr;
+    }
+
+    auto& list = cache.free[index];
+    if (!list) {
+        cache.counts[index] = take(pool, index, list, Batch);
+        if (!list) return nullptr;
+    }
+
+    auto block = list;
+    list = block->next;
+    --cache.counts[index];
+    return block;
+}
+
+void releaseSmall(Pool& pool, uint32_t index, void* memory) noexcept
+{
+    auto block = static_cast<Block*>(memory);
+    if (cacheDestroyed) {
+        block->next = nullptr;
+        give(pool, index, block, 1);
+        return;
+    }
+
+    auto& list = cache.free[index];
+    block->next = list;
+    list = block;
+    if (++cache.counts[index] > CacheLimit) {
+        give(pool, index, list, Batch);
+        cache.counts[index] -= Batch;
+    }
+}
+
+void* ENET_CALLBACK enetMalloc(size_t size)
+{
+    return Allocator::allocate(size);
+}
+
+void ENET_CALLBACK enetFree(void* memory)
+{
+    Allocator::release(memory);
+}
+
+} // \anonymous
+
+void Allocator::install(const Settings& settings)
+{
+    auto& pool = getPool();
+    {
+        std::lock_guard<std::mutex> lock{pool.mutex};
+        pool.settings = settings;
+        if (pool.installed) return;
+    }
+
+    // ENet keeps the callbacks after deinitialisation
+    ENetCallbacks callbacks{enetMalloc, enetFree, nullptr};
+    if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks)) {
+        throw Exception{"Cannot install allocator"};
+    }
+    enet_deinitialize();
+
+    std::lock_guard<std::mutex> lock{pool.mutex};
+    pool.installed = true;
+}
+
+bool Allocator::isInstalled() noexcept
+{
+    auto& pool = getPool();
+    std::lock_guard<std::mutex> lock{pool.mutex};
+    return pool.installed;
+}
+
+Allocator::Settings Allocator::getSettings() noexcept
+{
+    auto& pool = getPool();
+    std::lock_guard<std::mutex> lock{pool.mutex};
+    return pool.settings;
+}
+
+Allocator::Stats Allocator::getStats() noexcept
+{
+    const auto& pool = getPool();
+    return {
+        pool.live.load(std::memory_order_relaxed),
+        pool.peak.load(std::memory_order_relaxed),
+        pool.reserved.load(std::memory_order_relaxed),
+        pool.allocations.load(std::memory_order_relaxed),
+        pool.frees.load(std::memory_order_relaxed),
+        Clock::now()
+    };
+}
+
+double Allocator::getRate(const Stats& from, const Stats& to) noexcept
+{
+    using seconds = std::chrono::duration<double>;
+    const auto elapsed = seconds(to.time - from.time).count();
+    return elapsed > 0 ? (to.allocations - from.allocations) / elapsed : 0;
+}
+
+void* Allocator::allocate(size_t size) noexcept
+{
+    auto& pool = getPool();
+    const auto index = getClass(size);
+
+    void* memory = nullptr;
+    if (index == Big) {
+        auto block = static_cast<byte*>(std::malloc(sizeof(Header) + size));
+        if (!block) return nullptr;
+        reinterpret_cast<Header*>(block)->sizeClass = Big;
+        memory = block + sizeof(Header);
+        pool.reserved.fetch_add(size, std::memory_order_relaxed);
+    }
+    else {
+        memory = allocateSmall(pool, index);
+        if (!memory) return nullptr;
+    }
+    getHeader(memory).size = size;
+
+    const auto live = pool.live.fetch_add(size, std::memory_order_relaxed) +
+                      size;
+    auto peak = pool.peak.load(std::memory_order_relaxed);
+    while (live > peak && !pool.peak.compare_exchange_weak(
+        peak, live, std::memory_order_relaxed)) { }
+    pool.allocations.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+}
+
+void Allocator::release(void* memory) noexcept
+{
+    if (!memory) return;
+
+    auto& pool = getPool();
+    const auto& header = getHeader(memory);
+    pool.live.fetch_sub(header.size, std::memory_order_relaxed);
+    pool.frees.fetch_add(1, std::memory_order_relaxed);
+
+    if (header.sizeClass == Big) {
+        pool.reserved.fetch_sub(header.size, std::memory_order_relaxed);
+        std::free(&getHeader(memory));
+    }
+    else releaseSmall(pool, header.sizeClass, memory);
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,104 @@
+#include "wenet/buffer.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace sq {
+
+namespace wenet {
+
+namespace buffer_detail {
+
+void retain(Block& block) noexcept
+{
+    block.references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void release(Block& block) noexcept
+{
+    if (block.references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    if (block.release) block.release(block.data, block.context);
+    block.~Block();
+    ::operator delete(&block);
+}
+
+Block& allocate(size_t size)
+{
+    auto memory = ::operator new(sizeof(Block) + size);
+    auto data = reinterpret_cast<byte*>(memory) + sizeof(Block);
+    return *new (memory) Block{{1}, {data, std::ptrdiff_t(size)}, nullptr,
+                               nullptr};
+}
+
+} // \buffer_detail
+
+SharedBuffer::SharedBuffer(size_t size)
+    : block_(&buffer_detail::allocate(size)), data_(block_->data) { }
+
+SharedBuffer::SharedBuffer(span<const byte> data) : SharedBuffer(data.size())
+{
+    std::copy(data.begin(), data.end(), data_.begin());
+}
+
+SharedBuffer::SharedBuffer(span<byte> data, Release release, void* context)
+    : block_(new buffer_detail::Block{{1}, data, release, context}),
+      data_(data) { }
+
+SharedBuffer::SharedBuffer(const SharedBuffer& buffer) noexcept
+    : block_(buffer.block_), data_(buffer.data_)
+{
+    if (block_) buffer_detail::retain(*block_);
+}
+
+SharedBuffer::SharedBuffer(SharedBuffer&& buffer) noexcept
+    : block_(buffer.block_), data_(buffer.data_)
+{
+    buffer.block_ = nullptr;
+    buffer.data_ = {};
+}
+
+SharedBuffer& SharedBuffer::operator = (SharedBuffer buffer) noexcept
+{
+    std::swap(block_, buffer.block_);
+    std::swap(data_, buffer.data_);
+    return *this;
+}
+
+SharedBuffer::~SharedBuffer() noexcept
+{
+    if (block_) buffer_detail::release(*block_);
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset, size_t size) const
+{
+    if (offset + size > getSize()) throw Exception{"Slice is out of range"};
+
+    auto buffer = *this;
+    buffer.data_ = data_.subspan(offset, size);
+    return buffer;
+}
+
+size_t SharedBuffer::getReferences() const noexcept
+{
+    return block_ ? block_->references.load(std::memory_order_relaxed) : 0;
+}
+
+ENetPacket& SharedBuffer::createPacket(uint32_t flags) const noexcept
+{
+    auto& packet = *enet_packet_create(data_.data(), data_.size(),
+                                       flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    buffer_detail::retain(*block_);
+    packet.userData = block_;
+    packet.freeCallback = onPacketFree;
+    return packet;
+}
+
+void SharedBuffer::onPacketFree(ENetPacket* packet)
+{
+    buffer_detail::release(*static_cast<buffer_detail::Block*>(packet->userData));
+}
+
+} // \wenet
+
+} // \sq
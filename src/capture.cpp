@@ -0,0 +1,203 @@
+#include "wenet/capture.hpp"
+
+#include "wenet/host.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr byte Magic[] = {'W', 'N', 'E', 'T', 'C', 'A', 'P', '1'};
+
+// magic, used bytes, reserved
+constexpr auto HeaderSize = 32u;
+constexpr auto UsedOffset = sizeof(Magic);
+
+// time in ns, host, port, length, then data
+constexpr auto RecordHeaderSize = 8u + 4u + 2u + 2u;
+
+constexpr auto ReplayBatch = 32u; // datagrams sent between services
+
+template <typename T>
+void store(byte* destination, T value) noexcept
+{
+    std::memcpy(destination, &value, sizeof(value));
+}
+
+template <typename T>
+T load(const byte* source) noexcept
+{
+    T value;
+    std::memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+uint32_t getLoopback() noexcept
+{
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    return address.host;
+}
+
+} // \anonymous
+
+// Capture
+
+Capture::Capture(cstring_span<> path, size_t size)
+    : file_(path, HeaderSize + size), start_(Clock::now()), used_(HeaderSize)
+{
+    auto data = file_.getData().data();
+    std::copy(std::begin(Magic), std::end(Magic), data);
+    store(data + UsedOffset, uint64_t(used_));
+}
+
+bool Capture::write(const ENetAddress& address, span<const byte> data,
+                    Clock::time_point now) noexcept
+{
+    const auto size = RecordHeaderSize + data.size();
+    if (used_ + size > file_.getSize()) {
+        dropped_++;
+        return false;
+    }
+
+    using std::chrono::duration_cast;
+    const auto time = duration_cast<std::chrono::nanoseconds>(now - start_);
+
+    auto record = file_.getData().data() + used_;
+    store(record, uint64_t(time.count()));
+    store(record + 8, uint32_t(address.host));
+    store(record + 12, uint16_t(address.port));
+    store(record + 14, uint16_t(data.size()));
+    std::memcpy(record + RecordHeaderSize, data.data(), data.size());
+
+    // record becomes visible to readers only once it is complete
+    used_ += size;
+    store(file_.getData().data() + UsedOffset, uint64_t(used_));
+    return true;
+}
+
+// CaptureReader
+
+CaptureReader::CaptureReader(cstring_span<> path)
+    : file_(path), position_(HeaderSize)
+{
+    const auto data = file_.getData();
+    if (file_.getSize() < HeaderSize ||
+        !std::equal(std::begin(Magic), std::end(Magic), data.begin())) {
+        throw Capture::Exception{"Not a capture file"};
+    }
+
+    end_ = load<uint64_t>(data.data() + UsedOffset);
+    if (end_ < HeaderSize || end_ > file_.getSize()) {
+        throw Capture::Exception{"Capture file is damaged"};
+    }
+}
+
+bool CaptureReader::next(CaptureRecord& record) noexcept
+{
+    if (position_ + RecordHeaderSize > end_) return false;
+
+    const auto data = file_.getData().data() + position_;
+    const auto size = load<uint16_t>(data + 14);
+    if (position_ + RecordHeaderSize + size > end_) return false;
+
+    record.time = std::chrono::nanoseconds{load<uint64_t>(data)};
+    record.address.host = load<uint32_t>(data + 8);
+    record.address.port = load<uint16_t>(data + 12);
+    record.data = {data + RecordHeaderSize, size};
+
+    position_ += RecordHeaderSize + size;
+    return true;
+}
+
+void CaptureReader::rewind() noexcept
+{
+    position_ = HeaderSize;
+}
+
+// Replay
+
+Replay::Replay(cstring_span<> path) : reader_(path) { }
+
+Replay::~Replay() noexcept
+{
+    for (auto& socket : sockets_) enet_socket_destroy(socket.second);
+}
+
+Replay::Stats Replay::run(Host& host, bool realtime)
+{
+    using Clock = Host::Clock;
+    using std::chrono::duration_cast;
+
+    auto target = static_cast<ENetHost*>(host)->address;
+    if (target.host == ENET_HOST_ANY) target.host = getLoopback();
+
+    Stats stats{0, 0, 0ns};
+    const auto start = Clock::now();
+    auto last = start;
+
+    reader_.rewind();
+    CaptureRecord record;
+    while (reader_.next(record)) {
+        if (realtime) {
+            for (auto now = Clock::now(); now - start < record.time;
+                 now = Clock::now()) {
+                const auto left = record.time - (now - start);
+                host.service(std::min(duration_cast<time::ms>(left),
+                                      time::ms{1}));
+            }
+        }
+
+        const auto socket = getSocket(record.address);
+        ENetBuffer buffer{
+            const_cast<byte*>(record.data.data()), size_t(record.data.size())
+        };
+        auto sent = 0;
+        while (!(sent = enet_socket_send(socket, &target, &buffer, 1))) {
+            host.service(); // socket buffer is full, let the host catch up
+        }
+        if (sent < 0) throw Exception{"Cannot send datagram"};
+
+        stats.datagrams++;
+        stats.bytes += record.data.size();
+        if (realtime || stats.datagrams % ReplayBatch == 0) {
+            if (host.service()) last = Clock::now();
+        }
+    }
+
+    // whatever is still in flight, until the host goes quiet
+    while (host.service(time::ms{1})) last = Clock::now();
+
+    stats.elapsed = last - start;
+    return stats;
+}
+
+ENetSocket Replay::getSocket(const ENetAddress& source)
+{
+    const auto key = uint64_t(source.host) << 16 | source.port;
+    const auto it = sockets_.find(key);
+    if (it != sockets_.end()) return it->second;
+
+    const auto socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if (socket == ENET_SOCKET_NULL) throw Exception{"Cannot create socket"};
+
+    ENetAddress address{getLoopback(), 0};
+    if (enet_socket_bind(socket, &address) ||
+        enet_socket_set_option(socket, ENET_SOCKOPT_NONBLOCK, 1)) {
+        enet_socket_destroy(socket);
+        throw Exception{"Cannot bind socket"};
+    }
+
+    sockets_.emplace(key, socket);
+    return socket;
+}
+
+} // \wenet
+
+} // \sq
@@ -1,11 +1,289 @@
 #include "wenet/compressor.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 namespace sq {
 
 namespace wenet {
 
+namespace {
+
+enum Header : byte { Raw = 0, Compressed = 1 };
+
+constexpr auto RawHeaderSize = 1u;
+constexpr auto CompressedHeaderSize = 1u + 4u; // and original size
+constexpr auto MinimumSize = 64u; // smaller packets are not worth it
+constexpr auto MaximumSize = 32u * 1024u * 1024u;
+
+// ENet leaves other flag bits alone, this one marks packets that have been
+// compressed already and might be queued for more peers
+constexpr uint32_t Prepared = 1u << 15;
+
+// Every sync flush ends with an empty stored block, it is left out on the
+// wire and fed back to inflate
+constexpr byte SyncTail[] = {0x00, 0x00, 0xff, 0xff};
+
+void writeSize(byte* data, uint32_t size) noexcept
+{
+    for (auto i = 0; i < 4; ++i) data[i] = byte(size >> (24 - i * 8));
+}
+
+uint32_t readSize(const byte* data) noexcept
+{
+    auto size = uint32_t(0);
+    for (auto i = 0; i < 4; ++i) size = size << 8 | data[i];
+    return size;
+}
+
+} // \anonymous
+
+// PacketCompression
+
+void PacketCompression::setCompressor(
+    std::unique_ptr<Compressor> compressor) noexcept
+{
+    compressor_ = std::move(compressor);
+}
+
+bool PacketCompression::isEnabled(uint8_t channelId) const noexcept
+{
+    return compressor_ && channels_[channelId];
+}
+
+void PacketCompression::compress(uint8_t channelId, ENetPacket& packet)
+{
+    if (!isEnabled(channelId) || packet.flags & Prepared) return;
+    packet.flags |= Prepared;
+
+    const auto size = packet.dataLength;
+    buffer_.resize(size + RawHeaderSize);
+
+    // compressed packet has to be smaller than raw one to be worth it
+    const auto limit = size + RawHeaderSize - CompressedHeaderSize;
+    auto length = size_t(0);
+    if (size >= MinimumSize) {
+        const auto out = span<byte>{&buffer_[CompressedHeaderSize],
+                                    std::ptrdiff_t(limit)};
+        length = compressor_->compress({{packet.data, std::ptrdiff_t(size)}},
+                                       size, out);
+    }
+
+    if (length && length < limit) {
+        buffer_[0] = Compressed;
+        writeSize(&buffer_[1], size); // big endian
+        length += CompressedHeaderSize;
+    }
+    else {
+        buffer_[0] = Raw;
+        std::copy(packet.data, packet.data + size, &buffer_[RawHeaderSize]);
+        length = size + RawHeaderSize;
+    }
+    rewrite(packet, {buffer_.data(), std::ptrdiff_t(length)});
+}
+
+ENetPacket* PacketCompression::decompress(ENetPacket& packet)
+{
+    const auto data = packet.data;
+    const auto length = packet.dataLength;
+    if (!length) return nullptr;
+
+    if (data[0] == Raw) {
+        std::memmove(data, data + RawHeaderSize, length - RawHeaderSize);
+        enet_packet_resize(&packet, length - RawHeaderSize);
+        return &packet;
+    }
+    if (data[0] != Compressed || length < CompressedHeaderSize) return nullptr;
+
+    // compress() never sends an empty payload or size, the compressors
+    // cannot take empty spans
+    const auto size = readSize(data + 1);
+    if (length == CompressedHeaderSize || !size) return nullptr;
+    if (size > MaximumSize) return nullptr;
+
+    auto result = enet_packet_create(nullptr, size, packet.flags);
+    if (!result) return nullptr;
+    const auto in = span<const byte>{data, std::ptrdiff_t(length)}
+                        .subspan(CompressedHeaderSize);
+    const auto out = span<byte>{result->data, std::ptrdiff_t(size)};
+    if (compressor_->decompress(in, out) != size) {
+        enet_packet_destroy(result);
+        return nullptr;
+    }
+    return result;
+}
+
+void PacketCompression::rewrite(ENetPacket& packet,
+                                span<const byte> data) const noexcept
+{
+    if (packet.flags & ENET_PACKET_FLAG_NO_ALLOCATE) {
+        // user memory is no longer referenced, so it is released right away
+        auto memory = static_cast<byte*>(enet_malloc(data.size()));
+        if (packet.freeCallback) packet.freeCallback(&packet);
+        packet.freeCallback = nullptr;
+        packet.userData = nullptr;
+        packet.flags &= ~ENET_PACKET_FLAG_NO_ALLOCATE;
+        packet.data = memory;
+        packet.dataLength = data.size();
+    }
+    else enet_packet_resize(&packet, data.size());
+
+    std::copy(data.begin(), data.end(), packet.data);
+}
+
+// StatefulCompression
+
+struct StatefulCompression::Stream {
+    z_stream deflater{};
+    z_stream inflater{};
+    bool deflating = false;
+    bool inflating = false;
+
+    ~Stream() noexcept
+    {
+        if (deflating) deflateEnd(&deflater);
+        if (inflating) inflateEnd(&inflater);
+    }
+};
+
+StatefulCompression::StatefulCompression(size_t peerCount)
+    : slots_(peerCount) { }
+
+StatefulCompression::~StatefulCompression() noexcept = default;
+
+void StatefulCompression::setSettings(const Settings& settings) noexcept
+{
+    settings_ = settings;
+}
+
+bool StatefulCompression::isEnabled(uint8_t channelId) const noexcept
+{
+    return channels_[channelId];
+}
+
+ENetPacket* StatefulCompression::compress(const ENetPeer& peer,
+                                          uint8_t channelId,
+                                          const ENetPacket& packet)
+{
+    // copies own their data, user memory and buffer_ are not theirs
+    const auto flags = packet.flags &
+                       ~(Prepared | ENET_PACKET_FLAG_NO_ALLOCATE);
+    const auto size = packet.dataLength;
+    const auto reliable = packet.flags & ENET_PACKET_FLAG_RELIABLE;
+    if (!reliable || size < MinimumSize) {
+        auto result = enet_packet_create(nullptr, size + RawHeaderSize,
+                                         flags);
+        if (!result) return nullptr;
+        result->data[0] = Raw;
+        std::copy(packet.data, packet.data + size,
+                  result->data + RawHeaderSize);
+        return result;
+    }
+
+    auto& stream = getStream(peer, channelId);
+    auto& deflater = stream.deflater;
+    if (!stream.deflating) {
+        if (deflateInit2(&deflater, settings_.level, Z_DEFLATED,
+                         -settings_.windowBits, settings_.memLevel,
+                         Z_DEFAULT_STRATEGY) != Z_OK) return nullptr;
+        stream.deflating = true;
+    }
+
+    // one pass unless the bound is off, the flush needs a few more bytes
+    auto length = size_t(CompressedHeaderSize);
+    buffer_.resize(length + deflateBound(&deflater, size) + 16);
+    deflater.next_in = packet.data;
+    deflater.avail_in = size;
+    do {
+        if (length == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+        deflater.next_out = &buffer_[length];
+        deflater.avail_out = buffer_.size() - length;
+        const auto result = deflate(&deflater, Z_SYNC_FLUSH);
+        if (result != Z_OK && result != Z_BUF_ERROR) return nullptr;
+        length = buffer_.size() - deflater.avail_out;
+    } while (!deflater.avail_out);
+
+    const auto tail = sizeof(SyncTail);
+    if (length < CompressedHeaderSize + tail) return nullptr;
+    length -= tail;
+
+    buffer_[0] = Compressed;
+    writeSize(&buffer_[1], size);
+    return enet_packet_create(buffer_.data(), length, flags);
+}
+
+ENetPacket* StatefulCompression::decompress(const ENetPeer& peer,
+                                            uint8_t channelId,
+                                            ENetPacket& packet)
+{
+    const auto data = packet.data;
+    const auto length = packet.dataLength;
+    if (!length) return nullptr;
+
+    if (data[0] == Raw) {
+        std::memmove(data, data + RawHeaderSize, length - RawHeaderSize);
+        enet_packet_resize(&packet, length - RawHeaderSize);
+        return &packet;
+    }
+    if (data[0] != Compressed || length < CompressedHeaderSize) return nullptr;
+    if (!(packet.flags & ENET_PACKET_FLAG_RELIABLE)) return nullptr;
+
+    const auto size = readSize(data + 1);
+    if (size > MaximumSize) return nullptr;
+
+    auto& stream = getStream(peer, channelId);
+    auto& inflater = stream.inflater;
+    if (!stream.inflating) {
+        if (inflateInit2(&inflater, -settings_.windowBits) != Z_OK) {
+            return nullptr;
+        }
+        stream.inflating = true;
+    }
+
+    auto result = enet_packet_create(nullptr, size, packet.flags);
+    if (!result) return nullptr;
+    inflater.next_out = result->data;
+    inflater.avail_out = size;
+
+    const span<const byte> inputs[] = {
+        {data + CompressedHeaderSize,
+         std::ptrdiff_t(length - CompressedHeaderSize)},
+        SyncTail
+    };
+    for (auto input : inputs) {
+        inflater.next_in = const_cast<byte*>(input.data());
+        inflater.avail_in = input.size();
+        const auto status = inflate(&inflater, Z_SYNC_FLUSH);
+        if ((status != Z_OK && status != Z_BUF_ERROR) || inflater.avail_in) {
+            enet_packet_destroy(result);
+            return nullptr;
+        }
+    }
+
+    if (inflater.avail_out) {
+        enet_packet_destroy(result);
+        return nullptr;
+    }
+    return result;
+}
+
+void StatefulCompression::reset(const ENetPeer& peer) noexcept
+{
+    slots_[size_t(&peer - peer.host->peers)].clear();
+}
+
+StatefulCompression::Stream& StatefulCompression::getStream(
+    const ENetPeer& peer, uint8_t channelId)
+{
+    auto& slot = slots_[size_t(&peer - peer.host->peers)];
+    for (auto& channel : slot) {
+        if (channel.id == channelId) return *channel.stream;
+    }
+    slot.push_back({channelId, std::make_unique<Stream>()});
+    return *slot.back().stream;
+}
+
 namespace compressor {
 
 Zlib::Zlib()
@@ -64,7 +342,7 @@ size_t Zlib::decompress(span<const byte> in, span<byte> out) noexcept
 
     if (inflate(&streamInf_, Z_NO_FLUSH) != Z_STREAM_END) return 0;
 
-    return outMax - streamDef_.avail_out;
+    return outMax - streamInf_.avail_out;
 }
 
 } // \compressor
@@ -0,0 +1,250 @@
+#include "wenet/congestion.hpp"
+
+#include "outgoing.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr auto HighGain = 2.885; // 2/ln(2), doubles sending rate every round
+constexpr auto ProbeGain = 2.0; // window gain while cruising
+constexpr double CycleGains[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+constexpr auto Cycles = sizeof(CycleGains) / sizeof(CycleGains[0]);
+
+constexpr auto BandwidthRounds = 10u;
+constexpr auto FullBandwidthGrowth = 1.25;
+constexpr auto FullBandwidthRounds = 3u;
+
+constexpr auto MinRttWindow = 10s;
+constexpr auto MinSampleInterval = 10ms;
+constexpr auto QueueDelay = 10u; // ms of extra delay considered a queue
+constexpr auto BurstTime = 0.02; // s of pacing tokens that can accumulate
+
+constexpr auto InitialWindow = 10u; // in MTUs
+constexpr auto MinWindow = 4u; // in MTUs
+
+// Windowed max filter over rounds (Kathleen Nichols' algorithm) keeping the
+// best, second best and third best samples of the window
+template <typename Samples>
+uint32_t runningMax(Samples& samples, uint32_t window, uint32_t round,
+                    uint32_t value) noexcept
+{
+    const typename Samples::value_type sample{round, value};
+
+    if (value >= samples[0].value || round - samples[2].round > window) {
+        samples.fill(sample);
+        return value;
+    }
+
+    if (value >= samples[1].value) samples[2] = samples[1] = sample;
+    else if (value >= samples[2].value) samples[2] = sample;
+
+    const auto age = round - samples[0].round;
+    if (age > window) {
+        samples[0] = samples[1];
+        samples[1] = samples[2];
+        samples[2] = sample;
+        if (round - samples[0].round > window) {
+            samples[0] = samples[1];
+            samples[1] = samples[2];
+        }
+    }
+    else if (samples[1].round == samples[0].round && age > window / 4) {
+        samples[2] = samples[1] = sample;
+    }
+    else if (samples[2].round == samples[1].round && age > window / 2) {
+        samples[2] = sample;
+    }
+    return samples[0].value;
+}
+
+} // \anonymous
+
+CongestionControl::CongestionControl(size_t peerCount) : slots_(peerCount) { }
+
+void CongestionControl::reset(const ENetPeer& peer) noexcept
+{
+    getSlot(peer) = Slot{};
+}
+
+size_t CongestionControl::update(ENetPeer& peer, bool pending,
+                                 Clock::time_point now) noexcept
+{
+    auto& slot = getSlot(peer);
+    if (!slot.started) {
+        slot.started = true;
+        slot.sampleStart = slot.minRttStamp = slot.cycleStart = now;
+        slot.refill = now;
+    }
+
+    const size_t inFlight = peer.reliableDataInTransit +
+                            outgoing_detail::count(peer).bytes;
+
+    // unreliable data leaves ENet's queue whether it arrives or not, only
+    // reliable data no longer queued nor in transit is known to be delivered
+    const size_t unacknowledged = peer.reliableDataInTransit +
+                                  outgoing_detail::countReliable(peer).bytes;
+    const auto delivered = slot.reliable > unacknowledged ?
+                           slot.reliable - unacknowledged : 0;
+
+    const auto rtt = std::max(peer.roundTripTime, 1u);
+    if (!slot.minRtt || rtt <= slot.minRtt ||
+        now - slot.minRttStamp > MinRttWindow) {
+        slot.minRtt = rtt;
+        slot.minRttStamp = now;
+    }
+
+    sample(slot, peer, delivered, pending, now);
+    advance(slot, peer, inFlight, now);
+
+    // pacing, tokens go negative when a packet overshoots them
+    const auto rate = getPacingGain(slot, peer) * getEstimate(slot, peer);
+    const auto elapsed = std::chrono::duration<double>(now - slot.refill);
+    const auto burst = std::max(rate * BurstTime, 2.0 * peer.mtu);
+    slot.tokens = std::min(slot.tokens + rate * elapsed.count(), burst);
+    slot.refill = now;
+
+    // window, keeps no more than a few round trips worth of data in flight
+    const auto gain = slot.mode == Mode::ProbeBandwidth ? ProbeGain : HighGain;
+    const auto bdp = double(getEstimate(slot, peer)) * slot.minRtt / 1000;
+    const auto window = std::max(gain * bdp, double(MinWindow * peer.mtu));
+
+    if (slot.tokens <= 0 || inFlight >= window) return 0;
+    return size_t(std::min(slot.tokens, window - inFlight));
+}
+
+void CongestionControl::onSent(const ENetPeer& peer, size_t bytes,
+                               size_t reliable) noexcept
+{
+    auto& slot = getSlot(peer);
+    slot.reliable += reliable;
+    slot.tokens -= bytes;
+}
+
+CongestionControl::Mode
+CongestionControl::getMode(const ENetPeer& peer) const noexcept
+{
+    return getSlot(peer).mode;
+}
+
+speed::bs CongestionControl::getBandwidth(const ENetPeer& peer) const noexcept
+{
+    return getSlot(peer).bandwidth[0].value;
+}
+
+speed::bs CongestionControl::getPacingRate(const ENetPeer& peer) const noexcept
+{
+    auto& slot = getSlot(peer);
+    return speed::bs(getPacingGain(slot, peer) * getEstimate(slot, peer));
+}
+
+time::ms CongestionControl::getMinRoundTripTime(const ENetPeer& peer) const noexcept
+{
+    return time::ms{getSlot(peer).minRtt};
+}
+
+CongestionControl::Slot& CongestionControl::getSlot(const ENetPeer& peer) noexcept
+{
+    return slots_[size_t(&peer - peer.host->peers)];
+}
+
+const CongestionControl::Slot&
+CongestionControl::getSlot(const ENetPeer& peer) const noexcept
+{
+    return slots_[size_t(&peer - peer.host->peers)];
+}
+
+void CongestionControl::sample(Slot& slot, ENetPeer& peer, uint64_t delivered,
+                               bool pending, Clock::time_point now) noexcept
+{
+    const auto interval = now - slot.sampleStart;
+    if (interval < std::max<Clock::duration>(time::ms{slot.minRtt},
+                                             MinSampleInterval)) {
+        return;
+    }
+
+    const auto bytes = delivered > slot.delivered ? delivered - slot.delivered : 0;
+    const auto seconds = std::chrono::duration<double>(interval).count();
+    const auto rate = uint32_t(std::min(
+        bytes / seconds, double(std::numeric_limits<uint32_t>::max())));
+
+    slot.delivered = delivered;
+    slot.sampleStart = now;
+    slot.round++;
+
+    // nothing was waiting to be sent, so the sample only shows how much the
+    // application sent and says nothing about the path unless it is higher
+    if (!pending && rate < slot.bandwidth[0].value) return;
+
+    runningMax(slot.bandwidth, BandwidthRounds, slot.round, rate);
+}
+
+void CongestionControl::advance(Slot& slot, ENetPeer& peer, size_t inFlight,
+                                Clock::time_point now) noexcept
+{
+    const auto estimate = getEstimate(slot, peer);
+
+    switch (slot.mode) {
+    case Mode::Startup:
+        if (slot.round == slot.checkedRound) break; // once per round
+        slot.checkedRound = slot.round;
+
+        if (estimate >= slot.fullBandwidth * FullBandwidthGrowth) {
+            slot.fullBandwidth = estimate;
+            slot.fullRounds = 0;
+        }
+        else if (++slot.fullRounds >= FullBandwidthRounds) {
+            slot.mode = Mode::Drain;
+        }
+        break;
+
+    case Mode::Drain:
+        if (inFlight <= double(estimate) * slot.minRtt / 1000) {
+            slot.mode = Mode::ProbeBandwidth;
+            slot.cycle = 2; // start cruising, not probing
+            slot.cycleStart = now;
+        }
+        break;
+
+    case Mode::ProbeBandwidth:
+        if (now - slot.cycleStart >= time::ms{slot.minRtt}) {
+            slot.cycle = (slot.cycle + 1) % Cycles;
+            slot.cycleStart = now;
+        }
+        break;
+    }
+}
+
+double CongestionControl::getPacingGain(const Slot& slot,
+                                        const ENetPeer& peer) const noexcept
+{
+    auto gain = 1.0;
+    switch (slot.mode) {
+    case Mode::Startup: gain = HighGain; break;
+    case Mode::Drain: gain = 1 / HighGain; break;
+    case Mode::ProbeBandwidth: gain = CycleGains[slot.cycle]; break;
+    }
+
+    // delay based part, round trip time growing well above the minimum
+    // means a queue is building up on the path so do not push any harder
+    if (gain > 1 && peer.roundTripTime > 2 * slot.minRtt + QueueDelay) gain = 1;
+    return gain;
+}
+
+uint32_t CongestionControl::getEstimate(const Slot& slot,
+                                        const ENetPeer& peer) const noexcept
+{
+    if (slot.bandwidth[0].value) return slot.bandwidth[0].value;
+    return InitialWindow * peer.mtu * 1000 / std::max(slot.minRtt, 1u);
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,259 @@
+#include "wenet/correction.hpp"
+
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+enum Header : byte { Whole = 0, Shard = 1 };
+
+// type, group id, index, data and parity shard count, packet size
+constexpr auto WholeHeaderSize = 1u;
+constexpr auto ShardHeaderSize = 1u + 4u + 1u + 1u + 1u + 4u;
+constexpr auto MaximumShards = 255u;
+constexpr auto MaximumSize = 32u * 1024u * 1024u;
+// ENet protocol and command headers and the checksum in a datagram
+constexpr auto DatagramOverhead = 32u;
+
+void write32(byte* data, uint32_t value) noexcept
+{
+    for (auto i = 0; i < 4; ++i) data[i] = byte(value >> (24 - i * 8));
+}
+
+uint32_t read32(const byte* data) noexcept
+{
+    auto value = uint32_t(0);
+    for (auto i = 0; i < 4; ++i) value = value << 8 | data[i];
+    return value;
+}
+
+void combine(byte* target, const byte* source, size_t size) noexcept
+{
+    for (auto i = size_t(0); i < size; ++i) target[i] ^= source[i];
+}
+
+} // \anonymous
+
+ErrorCorrection::ErrorCorrection(size_t peerCount) : slots_(peerCount) { }
+
+void ErrorCorrection::setSettings(const Settings& settings) noexcept
+{
+    settings_ = {std::max(settings.stripe, size_t(1)), settings.shardSize};
+}
+
+bool ErrorCorrection::isEnabled(uint8_t channelId) const noexcept
+{
+    return channels_[channelId];
+}
+
+span<ENetPacket* const> ErrorCorrection::encode(const ENetPeer& peer,
+                                                const ENetPacket& packet)
+{
+    shards_.clear();
+
+    const auto size = packet.dataLength;
+    const auto shardSize = settings_.shardSize ? settings_.shardSize :
+        std::max(peer.mtu, DatagramOverhead * 2) - DatagramOverhead -
+        ShardHeaderSize;
+    const auto data = (size + shardSize - 1) / shardSize;
+    const auto parity = (data + settings_.stripe - 1) / settings_.stripe;
+
+    // reliable ones are resent anyway, small ones are not fragmented and the
+    // index and counts of a shard are a byte each
+    const auto reliable = packet.flags & ENET_PACKET_FLAG_RELIABLE;
+    if (reliable || data < 2 || data + parity > MaximumShards) {
+        const auto flags = packet.flags & ~ENET_PACKET_FLAG_NO_ALLOCATE;
+        auto whole = enet_packet_create(nullptr, size + WholeHeaderSize,
+                                        flags);
+        if (!whole) return {};
+        whole->data[0] = Whole;
+        std::copy(packet.data, packet.data + size,
+                  whole->data + WholeHeaderSize);
+        shards_.push_back(whole);
+        return shards_;
+    }
+
+    const auto id = group_++;
+    const auto flags = packet.flags & ENET_PACKET_FLAG_UNSEQUENCED;
+    for (auto i = size_t(0); i < data + parity; ++i) {
+        auto shard = enet_packet_create(nullptr, ShardHeaderSize + shardSize,
+                                        flags);
+        if (!shard) {
+            for (auto created : shards_) enet_packet_destroy(created);
+            shards_.clear();
+            return {};
+        }
+        shards_.push_back(shard);
+
+        auto header = shard->data;
+        header[0] = Shard;
+        write32(header + 1, id);
+        header[5] = byte(i);
+        header[6] = byte(data);
+        header[7] = byte(parity);
+        write32(header + 8, uint32_t(size));
+
+        auto payload = header + ShardHeaderSize;
+        if (i < data) {
+            // the last one is padded for the parity
+            const auto offset = i * shardSize;
+            const auto length = std::min(shardSize, size - offset);
+            std::copy(packet.data + offset, packet.data + offset + length,
+                      payload);
+            std::fill(payload + length, payload + shardSize, 0);
+        }
+        else {
+            std::fill(payload, payload + shardSize, 0);
+            for (auto j = i - data; j < data; j += parity) {
+                combine(payload, shards_[j]->data + ShardHeaderSize,
+                        shardSize);
+            }
+        }
+    }
+    return shards_;
+}
+
+ENetPacket* ErrorCorrection::decode(const ENetPeer& peer, uint8_t channelId,
+                                    ENetPacket& packet)
+{
+    const auto data = packet.data;
+    const auto length = packet.dataLength;
+    if (!length) return nullptr;
+
+    if (data[0] == Whole) {
+        std::move(data + WholeHeaderSize, data + length, data);
+        enet_packet_resize(&packet, length - WholeHeaderSize);
+        return &packet;
+    }
+    if (data[0] != Shard || length <= ShardHeaderSize) return nullptr;
+
+    const auto id = read32(data + 1);
+    const auto index = size_t(data[5]);
+    const auto dataCount = size_t(data[6]);
+    const auto parity = size_t(data[7]);
+    const auto size = size_t(read32(data + 8));
+    const auto shardSize = length - ShardHeaderSize;
+    if (!dataCount || parity > dataCount || index >= dataCount + parity ||
+        size > dataCount * shardSize || size <= (dataCount - 1) * shardSize ||
+        (dataCount + parity) * shardSize > MaximumSize) return nullptr;
+
+    auto group = getGroup(getChannel(peer, channelId), id);
+    if (!group || group->done) return nullptr;
+
+    if (!group->used) {
+        group->used = true;
+        group->data = dataCount;
+        group->parity = parity;
+        group->size = size;
+        group->shardSize = shardSize;
+        group->shards.resize((dataCount + parity) * shardSize);
+        group->received.assign(dataCount + parity, false);
+        group->count = 0;
+    }
+    else if (group->data != dataCount || group->parity != parity ||
+             group->size != size || group->shardSize != shardSize) {
+        return nullptr;
+    }
+
+    if (group->received[index]) return nullptr;
+    std::copy(data + ShardHeaderSize, data + length,
+              &group->shards[index * shardSize]);
+    group->received[index] = true;
+    group->count++;
+
+    if (group->count < dataCount) return nullptr;
+    return rebuild(*group, packet.flags);
+}
+
+void ErrorCorrection::reset(const ENetPeer& peer) noexcept
+{
+    slots_[size_t(&peer - peer.host->peers)].clear();
+}
+
+ErrorCorrection::Group*
+ErrorCorrection::getGroup(Channel& channel, uint32_t id) noexcept
+{
+    Group* free = nullptr;
+    Group* oldest = nullptr;
+    for (auto& group : channel.groups) {
+        if (!group.used) {
+            free = &group;
+            continue;
+        }
+        if (group.id == id) return &group;
+        if (!oldest || int32_t(group.id - oldest->id) < 0) oldest = &group;
+    }
+    if (free) {
+        free->id = id;
+        return free;
+    }
+
+    // late shard of a packet given up on already
+    if (int32_t(id - oldest->id) < 0) return nullptr;
+
+    if (!oldest->done) stats_.incomplete++;
+    oldest->used = oldest->done = false;
+    oldest->id = id;
+    return oldest;
+}
+
+ENetPacket* ErrorCorrection::rebuild(Group& group, uint32_t flags)
+{
+    const auto shardSize = group.shardSize;
+    const auto shard = [&](size_t index) {
+        return &group.shards[index * shardSize];
+    };
+
+    // a stripe missing one of its shards, parity included, gets it back
+    auto missing = false, recovered = false;
+    for (auto stripe = size_t(0); stripe < group.parity; ++stripe) {
+        const auto parity = group.data + stripe;
+        auto lost = size_t(0), last = size_t(0);
+        for (auto i = stripe; i < group.data; i += group.parity) {
+            if (group.received[i]) continue;
+            lost++;
+            last = i;
+        }
+        if (!lost) continue;
+        if (lost > 1 || !group.received[parity]) {
+            missing = true;
+            continue;
+        }
+
+        std::copy(shard(parity), shard(parity) + shardSize, shard(last));
+        for (auto i = stripe; i < group.data; i += group.parity) {
+            if (i != last) combine(shard(last), shard(i), shardSize);
+        }
+        group.received[last] = true;
+        recovered = true;
+    }
+    if (!group.parity) {
+        missing = std::find(group.received.begin(), group.received.end(),
+                            false) != group.received.end();
+    }
+    if (missing) return nullptr;
+
+    auto result = enet_packet_create(group.shards.data(), group.size, flags);
+    if (!result) return nullptr;
+    group.done = true;
+    if (recovered) stats_.recovered++;
+    return result;
+}
+
+ErrorCorrection::Channel& ErrorCorrection::getChannel(const ENetPeer& peer,
+                                                      uint8_t channelId)
+{
+    auto& slot = slots_[size_t(&peer - peer.host->peers)];
+    for (auto& channel : slot) {
+        if (channel.id == channelId) return channel;
+    }
+    slot.push_back({channelId, {}});
+    return slot.back();
+}
+
+} // \wenet
+
+} // \sq
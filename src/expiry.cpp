@@ -0,0 +1,68 @@
+#include "wenet/expiry.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+void unreference(ENetPacket& packet) noexcept
+{
+    if (!--packet.referenceCount) enet_packet_destroy(&packet);
+}
+
+} // \anonymous
+
+Expiry::~Expiry() noexcept
+{
+    for (auto& deadline : deadlines_) unreference(*deadline.first);
+}
+
+void Expiry::track(ENetPacket& packet, Clock::time_point deadline)
+{
+    if (deadline == Clock::time_point{}) return;
+    if (packet.flags & ENET_PACKET_FLAG_RELIABLE) return;
+
+    if (deadlines_.emplace(&packet, deadline).second) packet.referenceCount++;
+}
+
+bool Expiry::update(Clock::time_point now) noexcept
+{
+    now_ = now;
+
+    auto late = false;
+    for (auto it = deadlines_.begin(); it != deadlines_.end();) {
+        auto& packet = *it->first;
+        if (packet.referenceCount == 1) {
+            it = deadlines_.erase(it);
+            unreference(packet);
+            continue;
+        }
+        late = late || it->second <= now;
+        ++it;
+    }
+    return late;
+}
+
+bool Expiry::isExpired(const ENetPacket& packet) const noexcept
+{
+    const auto it = deadlines_.find(const_cast<ENetPacket*>(&packet));
+    return it != deadlines_.end() && it->second <= now_;
+}
+
+void Expiry::release() noexcept
+{
+    for (auto it = deadlines_.begin(); it != deadlines_.end();) {
+        if (it->second > now_) {
+            ++it;
+            continue;
+        }
+        auto& packet = *it->first;
+        it = deadlines_.erase(it);
+        unreference(packet);
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -1,5 +1,13 @@
 #include "wenet/host.hpp"
 
+#include "outgoing.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
 namespace sq {
 
 namespace wenet {
@@ -12,11 +20,16 @@ void Host::Deleter::operator () (ENetHost* host) const noexcept
 }
 
 std::atomic<size_t> Host::objects_{0};
+thread_local Host* Host::servicing_ = nullptr;
 
 Host::Host(size_t peerCount, const ENetAddress* address)
     : Host(address ? Address{*address} : Address{}, peerCount) { }
 
 Host::Host(const Address& address, size_t peerCount)
+    : streams_(*this, peerCount), scheduler_(peerCount),
+      congestion_(peerCount), pacer_(peerCount),
+      statefulCompression_(peerCount),
+      errorCorrection_(peerCount), table_(peerCount)
 {
     if (!objects_++) {
         if (enet_initialize()) {
@@ -26,6 +39,8 @@ Host::Host(const Address& address, size_t peerCount)
     host_.reset(enet_host_create(address, peerCount, 0u, 0u, 0u));
     if (!host_) throw InitException{"Cannot initialise host"};
     peers_.reserve(peerCount);
+    slots_.resize(peerCount);
+    disconnected_.reserve(peerCount); // a peer is in it once at most
 }
 
 Peer& Host::connect(const Address& address)
@@ -57,16 +72,66 @@ void Host::setChannelLimit(size_t limit) noexcept
     enet_host_channel_limit(host_.get(), limit);
 }
 
-void Host::broadcast(Packet& packet, uint8_t channelId) const noexcept
+void Host::broadcast(Packet& packet, uint8_t channelId) noexcept
 {
     if (packet.isOwned()) packet.releaseOwnership();
-    enet_host_broadcast(host_.get(), channelId, packet);
+    broadcastShared(packet, channelId);
 }
 
-void Host::broadcast(Packet&& packet, uint8_t channelId) const noexcept
+void Host::broadcast(Packet&& packet, uint8_t channelId) noexcept
 {
     packet.releaseOwnership();
-    enet_host_broadcast(host_.get(), channelId, packet);
+    broadcastShared(packet, channelId);
+}
+
+size_t Host::sendTo(span<const Peer* const> peers, Packet&& packet,
+                    uint8_t channelId) noexcept
+{
+    return fanOut(std::move(packet), channelId, [&](auto send) {
+        for (auto peer : peers) {
+            if (auto enetPeer = static_cast<ENetPeer*>(*peer)) send(*enetPeer);
+        }
+    });
+}
+
+size_t Host::broadcastExcept(const Peer& peer, Packet&& packet,
+                             uint8_t channelId) noexcept
+{
+    const auto except = static_cast<ENetPeer*>(peer);
+    return fanOut(std::move(packet), channelId, [&](auto send) {
+        auto peers = span<ENetPeer>{
+            host_->peers, std::ptrdiff_t(host_->peerCount)
+        };
+        for (auto& other : peers) if (&other != except) send(other);
+    });
+}
+
+size_t Host::sendEach(BuildCallback build, uint8_t channelId)
+{
+    if (!pool_) pool_ = std::make_unique<WorkPool>();
+
+    built_.clear(); // whatever a failed build left behind
+    built_.resize(peers_.size());
+    builtFor_.clear();
+    for (auto& peer : peers_) builtFor_.push_back(peer);
+    pool_->run(peers_.size(), [&](size_t index) {
+        built_[index] = build(peers_[index]);
+    });
+
+    // a send can disconnect its peer, which reorders peers_
+    auto sent = size_t(0);
+    for (auto i = size_t(0); i < builtFor_.size(); ++i) {
+        if (!built_[i].isInit()) continue;
+        auto peer = findPeer(*builtFor_[i]);
+        if (peer) sent += peer->send(std::move(built_[i]), channelId);
+    }
+    built_.clear(); // releases packets that were not queued
+    return sent;
+}
+
+void Host::setWorkThreads(size_t threads)
+{
+    pool_ = std::make_unique<WorkPool>(threads);
 }
 
 void Host::onReceive(Callback callback) noexcept
@@ -84,16 +149,139 @@ void Host::onDisconnect(DisconnectCallback callback) noexcept
     cbDisconnect_ = std::move(callback);
 }
 
+void Host::route(uint8_t channelId, uint8_t messageId,
+                 Router::Handler handler, void* context)
+{
+    router_.add(channelId, messageId, handler, context);
+}
+
+void Host::unroute(uint8_t channelId, uint8_t messageId) noexcept
+{
+    router_.remove(channelId, messageId);
+}
+
+void Host::setQueueLimit(const Watermark& watermark, Overflow overflow) noexcept
+{
+    watermark_ = watermark;
+    overflow_ = overflow;
+}
+
+void Host::onHighWatermark(WatermarkCallback callback) noexcept
+{
+    cbHighWatermark_ = std::move(callback);
+}
+
+void Host::onLowWatermark(WatermarkCallback callback) noexcept
+{
+    cbLowWatermark_ = std::move(callback);
+}
+
+Host::Priority Host::getChannelPriority(uint8_t channelId) const noexcept
+{
+    return scheduler_.getPriority(channelId);
+}
+
+void Host::setChannelPriority(uint8_t channelId,
+                              const Priority& priority) noexcept
+{
+    scheduler_.setPriority(channelId, priority);
+}
+
+void Host::setCongestionControl(bool enabled) noexcept
+{
+    congestionControl_ = enabled;
+    if (enabled) scheduler_.enable();
+}
+
+const Pacer::Settings& Host::getPacing() const noexcept
+{
+    return pacer_.getSettings();
+}
+
+void Host::setPacing(const Pacer::Settings& settings) noexcept
+{
+    pacer_.setSettings(settings);
+    if (pacer_.isEnabled()) scheduler_.enable();
+}
+
+Pacer::Gaps Host::getPacingGaps() const noexcept
+{
+    return pacer_.getGaps();
+}
+
+void Host::setStreamChannel(uint8_t channelId) noexcept
+{
+    streams_.setChannel(channelId);
+}
+
+Host::StreamWindow Host::getStreamWindow() const noexcept
+{
+    return streams_.getWindow();
+}
+
+void Host::setStreamWindow(const StreamWindow& window) noexcept
+{
+    streams_.setWindow(window);
+}
+
+void Host::onStreamBegin(Streams::BeginCallback callback) noexcept
+{
+    streams_.onBegin(std::move(callback));
+}
+
+void Host::onStreamSent(Streams::ProgressCallback callback) noexcept
+{
+    streams_.onSent(std::move(callback));
+}
+
+void Host::onStreamReceived(Streams::ProgressCallback callback) noexcept
+{
+    streams_.onReceived(std::move(callback));
+}
+
+void Host::setAdmission(bool enabled) noexcept
+{
+    admission_.setEnabled(enabled);
+    updateIntercept();
+}
+
+Admission::Stats Host::getAdmissionStats() const noexcept
+{
+    return admission_.getStats();
+}
+
+RateLimiter::Limit Host::getRateLimit() const noexcept
+{
+    return limiter_.getLimit();
+}
+
+void Host::setRateLimit(const RateLimiter::Limit& limit) noexcept
+{
+    limiter_.setLimit(limit);
+    updateIntercept();
+}
+
+RateLimiter::Stats Host::getRateLimitStats() const noexcept
+{
+    return limiter_.getStats();
+}
+
+void Host::startCapture(cstring_span<> path, size_t size)
+{
+    capture_ = std::make_unique<Capture>(path, size);
+    updateIntercept();
+}
+
+void Host::stopCapture() noexcept
+{
+    capture_.reset();
+    updateIntercept();
+}
+
 bool Host::receive(int limit)
 {
-    ENetEvent event;
-    do {
-        auto result = enet_host_check_events(host_.get(), &event);
-        if (result > 0) parseEvent(event);
-        else if (result < 0) throw ReceiveEventException{"Cannot receive"};
-        else return false;
-    } while(--limit);
-    return true;
+    Callbacks callbacks{*this};
+    return receiveWith(limit, callbacks);
 }
 
 bool Host::service(int limit)
@@ -103,19 +291,74 @@ bool Host::service(int limit)
 
 bool Host::service(time::ms timeout, int limit)
 {
-    ENetEvent event;
-    do {
-        auto result = enet_host_service(host_.get(), &event, timeout.count());
-        if (result > 0) parseEvent(event);
-        else if (result < 0) throw ReceiveEventException{"Cannot receive"};
-        else return false;
-    } while(--limit);
-    return true;
+    Callbacks callbacks{*this};
+    return serviceWith(timeout, limit, callbacks);
+}
+
+bool Host::service(Clock::time_point deadline)
+{
+    Callbacks callbacks{*this};
+    return serviceWith(deadline, callbacks);
+}
+
+bool Host::poll(time::ms timeout)
+{
+    Callbacks callbacks{*this};
+    return pollWith(timeout, callbacks);
+}
+
+bool Host::setPolling(const Polling& polling) noexcept
+{
+    polling_ = polling;
+
+#ifdef SO_BUSY_POLL
+    int value = polling.busyPoll ? polling.spin.count() : 0;
+    if (!setsockopt(host_->socket, SOL_SOCKET, SO_BUSY_POLL, &value,
+                    sizeof(value))) {
+        return true;
+    }
+#endif
+
+    polling_.busyPoll = false;
+    return !polling.busyPoll;
+}
+
+time::us Host::getSpinWindow() const noexcept
+{
+    // spinning for twice the usual gap catches most of the events, if they are
+    // further apart than the limit it is cheaper to block right away
+    const auto window = 2 * arrivalInterval_;
+    if (!arrivalInterval_ || window > polling_.spin.count()) return time::us{0};
+    return time::us{uint32_t(window)};
+}
+
+Host::Backlog Host::getBacklog() const noexcept
+{
+    Backlog backlog{0, 0, false};
+
+    auto& queue = host_->dispatchQueue;
+    for (auto node = enet_list_begin(&queue); node != enet_list_end(&queue);
+         node = enet_list_next(node)) {
+        auto& peer = *reinterpret_cast<ENetPeer*>(node);
+        backlog.events += enet_list_size(&peer.dispatchedCommands);
+        if (peer.state == ENET_PEER_STATE_CONNECTION_SUCCEEDED ||
+            peer.state == ENET_PEER_STATE_ZOMBIE) {
+            backlog.events++; // connect or disconnect
+        }
+    }
+
+    auto peers = span<ENetPeer>{host_->peers, std::ptrdiff_t(host_->peerCount)};
+    for (auto& peer : peers) backlog.packets += scheduler_.count(peer).packets;
+
+    backlog.socket = isReadable();
+    return backlog;
 }
 
 void Host::flush()
 {
+    schedule();
     enet_host_flush(host_.get());
+    updateQueues();
 }
 
 void Host::disableCompression() noexcept
@@ -124,14 +367,104 @@ void Host::disableCompression() noexcept
     enet_host_compress(host_.get(), nullptr);
 }
 
+void Host::disablePacketCompression(uint8_t channelId) noexcept
+{
+    packetCompression_.disable(channelId);
+}
+
+bool Host::isPacketCompressed(uint8_t channelId) const noexcept
+{
+    return packetCompression_.isEnabled(channelId);
+}
+
+void Host::enableStatefulCompression(uint8_t channelId) noexcept
+{
+    packetCompression_.disable(channelId);
+    scheduler_.setKeyed(channelId, false);
+    errorCorrection_.disable(channelId);
+    statefulCompression_.enable(channelId);
+}
+
+void Host::disableStatefulCompression(uint8_t channelId) noexcept
+{
+    statefulCompression_.disable(channelId);
+}
+
+bool Host::isStatefullyCompressed(uint8_t channelId) const noexcept
+{
+    return statefulCompression_.isEnabled(channelId);
+}
+
+void Host::enableStateChannel(uint8_t channelId) noexcept
+{
+    // replacing a compressed packet would leave a gap in the history
+    statefulCompression_.disable(channelId);
+    scheduler_.setKeyed(channelId, true);
+}
+
+void Host::disableStateChannel(uint8_t channelId) noexcept
+{
+    scheduler_.setKeyed(channelId, false);
+}
+
+bool Host::isStateChannel(uint8_t channelId) const noexcept
+{
+    return scheduler_.isKeyed(channelId);
+}
+
+void Host::enableErrorCorrection(uint8_t channelId) noexcept
+{
+    statefulCompression_.disable(channelId);
+    errorCorrection_.enable(channelId);
+}
+
+void Host::disableErrorCorrection(uint8_t channelId) noexcept
+{
+    errorCorrection_.disable(channelId);
+}
+
+bool Host::isErrorCorrected(uint8_t channelId) const noexcept
+{
+    return errorCorrection_.isEnabled(channelId);
+}
+
+const ErrorCorrection::Settings& Host::getErrorCorrection() const noexcept
+{
+    return errorCorrection_.getSettings();
+}
+
+void Host::setErrorCorrection(
+    const ErrorCorrection::Settings& settings) noexcept
+{
+    errorCorrection_.setSettings(settings);
+}
+
+const ErrorCorrection::Stats& Host::getErrorCorrectionStats() const noexcept
+{
+    return errorCorrection_.getStats();
+}
+
+const StatefulCompression::Settings&
+Host::getStatefulCompression() const noexcept
+{
+    return statefulCompression_.getSettings();
+}
+
+void Host::setStatefulCompression(
+    const StatefulCompression::Settings& settings) noexcept
+{
+    statefulCompression_.setSettings(settings);
+}
+
 void Host::_onChecksum(decltype(ENetHost::checksum) callback) const noexcept
 {
     host_->checksum = callback;
 }
 
-void Host::_onIntercept(decltype(ENetHost::intercept) callback) const noexcept
+void Host::_onIntercept(decltype(ENetHost::intercept) callback) noexcept
 {
-    host_->intercept = callback;
+    cbIntercept_ = callback;
+    updateIntercept();
 }
 
 #if ENET_VERSION_CREATE(1, 3, 9) <= ENET_VERSION
@@ -192,45 +525,463 @@ uint32_t Host::getTotalSentPackets() const noexcept
     return host_->totalSentPackets;
 }
 
+Allocator::Stats Host::getAllocatorStats() noexcept
+{
+    return Allocator::getStats();
+}
+
+void Host::setPeerTracking(bool enabled) noexcept
+{
+    table_.setEnabled(enabled);
+    if (enabled) table_.refresh(*host_);
+}
+
+Peer& Host::getPeerAt(size_t slot) noexcept
+{
+    return getPeer(host_->peers[slot]);
+}
+
 void Host::removePeer(const Peer& peer) noexcept
 {
     removePeer(*static_cast<ENetPeer*>(peer));
 }
 
-void Host::parseEvent(ENetEvent& event)
+bool Host::isReadable() const noexcept
+{
+#ifdef __linux__
+    // peeking at the socket is cheaper than waiting on it
+    char data;
+    return recv(host_->socket, &data, 1, MSG_PEEK | MSG_DONTWAIT) >= 0;
+#else
+    enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+    if (enet_socket_wait(host_->socket, &condition, 0)) return false;
+    return condition & ENET_SOCKET_WAIT_RECEIVE;
+#endif
+}
+
+void Host::onArrival(Clock::time_point now) noexcept
 {
-    auto peer = event.peer;
+    using us = std::chrono::duration<double, std::micro>;
+
+    if (lastArrival_ != Clock::time_point{}) {
+        const auto interval = us(now - lastArrival_).count();
+        arrivalInterval_ = arrivalInterval_ ? arrivalInterval_ * 0.875 +
+                                              interval * 0.125 : interval;
+    }
+    lastArrival_ = now;
+}
+
+void Host::Callbacks::connect(Peer& peer, uint32_t data)
+{
+    if (host.cbConnect_) host.cbConnect_(peer, data);
+}
+
+void Host::Callbacks::receive(Peer& peer, Packet&& packet, uint8_t channelId)
+{
+    if (host.cbReceive_) host.cbReceive_(peer, std::move(packet), channelId);
+}
 
-    switch (event.type) {
-    case ENET_EVENT_TYPE_CONNECT: 
-        createPeer(*peer);
-        if (cbConnect_) cbConnect_(peers_.back(), event.data);
-        break;
+void Host::Callbacks::disconnect(size_t id, uint32_t data)
+{
+    if (host.cbDisconnect_) host.cbDisconnect_(id, data);
+}
+
+int Host::serviceEnet(ENetEvent& event, uint32_t timeout)
+{
+    const auto previous = servicing_;
+    servicing_ = this;
+    const auto result = pacer_.isEnabled() ?
+        servicePaced(event, timeout) :
+        enet_host_service(host_.get(), &event, timeout);
+    servicing_ = previous;
+
+    if (result < 0) throw ReceiveEventException{"Cannot receive"};
+    return result;
+}
+
+int Host::servicePaced(ENetEvent& event, uint32_t timeout)
+{
+    // waits in steps of half a burst while the pacer holds packets back,
+    // handing over what the buckets refilled for in between
+    const auto step = std::max(pacer_.getSettings().burst.count() / 2000, 1u);
+    const auto end = Clock::now() + time::ms{timeout};
+    for (;;) {
+        const auto left = std::chrono::duration_cast<time::ms>(
+            std::max(end - Clock::now(), Clock::duration{0})
+        ).count();
+        const auto wait = paced_ ? std::min(left, step) : left;
+        const auto result = enet_host_service(host_.get(), &event, wait);
+        if (result || wait == left) return result;
+        schedule();
+    }
+}
+
+ENetPacket* Host::prepareReceive(ENetEvent& event)
+{
+    auto packet = event.packet;
+    if (streams_.isEnabled() && event.channelID == streams_.getChannel()) {
+        streams_.receive(*event.peer, {*packet});
+        return nullptr;
+    }
+
+    if (statefulCompression_.isEnabled(event.channelID)) {
+        packet = statefulCompression_.decompress(*event.peer, event.channelID,
+                                                 *event.packet);
+        if (packet != event.packet) enet_packet_destroy(event.packet);
+        // the history cannot be recovered from a bad packet
+        if (!packet) enet_peer_disconnect(event.peer, 0);
+        return packet;
+    }
+
+    if (errorCorrection_.isEnabled(event.channelID)) {
+        packet = errorCorrection_.decode(*event.peer, event.channelID,
+                                         *event.packet);
+        if (packet != event.packet) enet_packet_destroy(event.packet);
+        if (!packet) return nullptr; // malformed or waiting for more shards
+    }
+
+    if (packetCompression_.isEnabled(event.channelID)) {
+        const auto compressed = packet;
+        packet = packetCompression_.decompress(*compressed);
+        if (packet != compressed) enet_packet_destroy(compressed);
+    }
+    return packet; // null when malformed
+}
+
+size_t Host::prepareDisconnect(ENetPeer& peer) noexcept
+{
+    getSlot(peer) = Slot{};
+    scheduler_.clear(peer);
+    congestion_.reset(peer);
+    pacer_.reset(peer);
+    streams_.reset(peer);
+    statefulCompression_.reset(peer);
+    errorCorrection_.reset(peer);
+    return getPeer(peer).getId();
+}
+
+void Host::finishService()
+{
+    removeDisconnected();
+    updateQueues();
+    if (table_.isEnabled()) table_.refresh(*host_);
+}
+
+void Host::updateIntercept() noexcept
+{
+    const auto wrapped = admission_.isEnabled() || limiter_.isEnabled() ||
+                         capture_;
+    host_->intercept = wrapped ? intercept : cbIntercept_;
+}
+
+int Host::intercept(ENetHost* host, ENetEvent* event)
+{
+    // the raw host serviced directly, the Host and its filters are unknown
+    if (!servicing_ || servicing_->host_.get() != host) return 0;
+
+    auto& self = *servicing_;
+    const auto now = Admission::Clock::now();
+    const auto bytes = host->receivedDataLength;
+    if (self.capture_) {
+        const auto data = span<const byte>{host->receivedData,
+                                           std::ptrdiff_t(bytes)};
+        self.capture_->write(host->receivedAddress, data, now);
+    }
+    if (self.limiter_.intercept(host->receivedAddress, bytes, now)) return 1;
+    if (self.admission_.intercept(*host, now)) return 1;
+
+    return self.cbIntercept_ ? self.cbIntercept_(host, event) : 0;
+}
+
+void Host::broadcastShared(const Packet& packet, uint8_t channelId) noexcept
+{
+    auto& shared = *static_cast<ENetPacket*>(packet);
+    packetCompression_.compress(channelId, shared);
 
-    case ENET_EVENT_TYPE_RECEIVE:
-        if (cbReceive_) {
-            cbReceive_(getPeer(*peer), {*event.packet}, event.channelID);
+    const auto stateless = !statefulCompression_.isEnabled(channelId) &&
+                           !errorCorrection_.isEnabled(channelId);
+    if (!watermark_.high && !scheduler_.isEnabled() && stateless) {
+        // before ENet can destroy it
+        expiry_.track(shared, packet.getDeadline());
+        enet_host_broadcast(host_.get(), channelId, &shared);
+        return;
+    }
+
+    auto peers = span<ENetPeer>{host_->peers, std::ptrdiff_t(host_->peerCount)};
+    for (auto& peer : peers) {
+        if (peer.state != ENET_PEER_STATE_CONNECTED) continue;
+        enqueue(peer, channelId, packet);
+    }
+
+    if (!shared.referenceCount) enet_packet_destroy(&shared);
+}
+
+bool Host::enqueue(ENetPeer& peer, uint8_t channelId, const Packet& packet)
+{
+    if (statefulCompression_.isEnabled(channelId)) {
+        return enqueueStateful(peer, channelId, packet);
+    }
+
+    packetCompression_.compress(channelId, *static_cast<ENetPacket*>(packet));
+    if (errorCorrection_.isEnabled(channelId)) {
+        return enqueueCorrected(peer, channelId, packet);
+    }
+
+    if (!admit(peer, packet)) return false;
+    auto& queued = *static_cast<ENetPacket*>(packet);
+    if (!submit(peer, channelId, queued, packet.getKey())) return false;
+    expiry_.track(queued, packet.getDeadline());
+    return true;
+}
+
+bool Host::enqueueStateful(ENetPeer& peer, uint8_t channelId,
+                           const Packet& packet)
+{
+    if (!admit(peer, packet)) return false;
+    // a packet compressed and then not sent would desync the history
+    if (peer.state != ENET_PEER_STATE_CONNECTED) return false;
+    if (channelId >= peer.channelCount) return false;
+
+    const auto compressed = statefulCompression_.compress(
+        peer, channelId, *static_cast<ENetPacket*>(packet)
+    );
+    if (compressed && submit(peer, channelId, *compressed)) {
+        expiry_.track(*compressed, packet.getDeadline());
+        return true;
+    }
+
+    if (compressed) enet_packet_destroy(compressed);
+    enet_peer_disconnect(&peer, 0);
+    return false;
+}
+
+bool Host::enqueueCorrected(ENetPeer& peer, uint8_t channelId,
+                            const Packet& packet)
+{
+    if (!admit(peer, packet)) return false;
+
+    // shards are new packets of the peer, the packet stays with its owner.
+    // A packet sent whole can still replace its key on a state channel
+    auto queued = false;
+    const auto shards = errorCorrection_.encode(
+        peer, *static_cast<ENetPacket*>(packet)
+    );
+    const auto key = shards.size() == 1 ? packet.getKey() : Packet::NoKey;
+    for (auto shard : shards) {
+        if (submit(peer, channelId, *shard, key)) {
+            expiry_.track(*shard, packet.getDeadline());
+            queued = true;
+        }
+        else if (!shard->referenceCount) enet_packet_destroy(shard);
+    }
+    return queued;
+}
+
+bool Host::submit(ENetPeer& peer, uint8_t channelId, ENetPacket& packet,
+                  uint64_t key)
+{
+    if (!scheduler_.isEnabled()) {
+        return !enet_peer_send(&peer, channelId, &packet);
+    }
+
+    // what ENet would refuse right away, later refusals are dropped packets
+    if (peer.state != ENET_PEER_STATE_CONNECTED) return false;
+    if (channelId >= peer.channelCount) return false;
+    if (packet.dataLength > host_->maximumPacketSize) return false;
+    if (key == Packet::NoKey) {
+        scheduler_.push(peer, channelId, packet);
+        return true;
+    }
+
+    auto& slot = getSlot(peer);
+    const auto replaced = scheduler_.push(peer, channelId, packet, key);
+    slot.queued -= std::min(replaced, slot.queued);
+    return true;
+}
+
+bool Host::admit(ENetPeer& peer, const Packet& packet)
+{
+    if (!watermark_.high) return true;
+
+    auto& slot = getSlot(peer);
+    const auto size = packet.getSize();
+    const auto fits = [&] { return slot.queued + size <= watermark_.high; };
+
+    if (!fits()) {
+        if (!slot.high) {
+            slot.high = true;
+            if (cbHighWatermark_) cbHighWatermark_(getPeer(peer), slot.queued);
         }
-        break;
 
-    case ENET_EVENT_TYPE_DISCONNECT:
-        if (cbDisconnect_) {
-            cbDisconnect_(getPeer(*peer).getId(), event.data);
+        switch (overflow_) {
+        case Overflow::Notify:
+            break;
+
+        case Overflow::DropOldest:
+            while (!fits()) {
+                auto bytes = outgoing_detail::dropOldestUnreliable(peer);
+                if (!bytes) bytes = scheduler_.dropOldestUnreliable(peer);
+                if (!bytes) break;
+                slot.queued -= std::min(bytes, slot.queued);
+                slot.dropped++;
+            }
+            // reliable packets are never dropped, unreliable one is the
+            // oldest left if queue is still full
+            if (!fits() && !(packet.getFlags() & Packet::Flag::Reliable)) {
+                slot.dropped++;
+                return false;
+            }
+            break;
+
+        case Overflow::Reject:
+            slot.dropped++;
+            return false;
+
+        case Overflow::Disconnect:
+            // removing the peer here would invalidate the Peer the caller
+            // holds and peers_ it may be iterating, finishService does it
+            if (peer.state != ENET_PEER_STATE_DISCONNECTED) {
+                enet_peer_disconnect_now(&peer, 0);
+                disconnected_.push_back(&peer);
+            }
+            return false;
         }
-        break;
+    }
+
+    slot.queued += size;
+    return true;
+}
+
+void Host::updateQueues()
+{
+    if (!watermark_.high) return;
+
+    auto peers = span<ENetPeer>{host_->peers, std::ptrdiff_t(host_->peerCount)};
+    for (auto& peer : peers) {
+        auto& slot = getSlot(peer);
+        if (!slot.queued && !slot.high) continue; // expiry may empty it
 
-    default:
-        break;
+        slot.queued = outgoing_detail::count(peer).bytes +
+                      scheduler_.count(peer).bytes;
+        if (slot.high && slot.queued <= watermark_.low) {
+            slot.high = false;
+            if (cbLowWatermark_) cbLowWatermark_(getPeer(peer), slot.queued);
+        }
     }
 }
 
+void Host::schedule()
+{
+    streams_.pump();
+    expire();
+    if (!scheduler_.isEnabled()) return;
+
+    const auto now = CongestionControl::Clock::now();
+    const auto paced = pacer_.isEnabled();
+    paced_ = false;
+
+    // starts after the last peer that sent, so when the host's pacing rate
+    // runs out the same peers are not always the ones left waiting
+    const auto count = size_t(host_->peerCount);
+    auto next = nextScheduled_;
+    for (auto i = size_t(0); i < count; ++i) {
+        const auto index = (nextScheduled_ + i) % count;
+        auto& peer = host_->peers[index];
+        if (peer.state != ENET_PEER_STATE_CONNECTED) continue;
+        auto reliable = size_t(0), refused = size_t(0);
+        if (!congestionControl_ && !paced) {
+            scheduler_.drain(peer, size_t(-1), reliable, refused);
+            getSlot(peer).dropped += refused;
+            continue;
+        }
+
+        auto limit = size_t(-1);
+        if (congestionControl_) {
+            const auto pending = scheduler_.count(peer).packets;
+            limit = congestion_.update(peer, pending, now);
+        }
+        if (paced) limit = std::min(limit, pacer_.update(peer, now));
+
+        const auto sent = scheduler_.drain(peer, limit, reliable, refused);
+        getSlot(peer).dropped += refused;
+        if (sent) next = index + 1;
+        if (congestionControl_) congestion_.onSent(peer, sent, reliable);
+        if (!paced) continue;
+
+        pacer_.onSent(peer, sent, now);
+        paced_ = paced_ || scheduler_.count(peer).packets;
+    }
+    nextScheduled_ = next % count;
+}
+
+void Host::expire()
+{
+    if (!expiry_.update(Clock::now())) return;
+
+    const auto late = [this](const ENetPacket& packet) {
+        return expiry_.isExpired(packet);
+    };
+
+    auto peers = span<ENetPeer>{host_->peers, std::ptrdiff_t(host_->peerCount)};
+    for (auto& peer : peers) {
+        if (peer.state == ENET_PEER_STATE_DISCONNECTED) continue;
+
+        auto& slot = getSlot(peer);
+        const auto count = [&slot](uint8_t channelId) {
+            if (channelId >= slot.expired.size()) {
+                slot.expired.resize(channelId + 1);
+            }
+            slot.expired[channelId]++;
+        };
+
+        auto bytes = scheduler_.dropUnreliable(peer, late, count);
+
+        // fragments of a packet are queued next to each other, the packet
+        // itself stays alive while expiry holds it
+        const ENetPacket* last = nullptr;
+        outgoing_detail::forEach(peer, [&](ENetOutgoingCommand& command) {
+            if (outgoing_detail::isReliable(command)) return;
+            if (!late(*command.packet)) return;
+
+            if (command.packet != last) count(command.command.header.channelID);
+            last = command.packet;
+            bytes += command.fragmentLength;
+            outgoing_detail::release(command);
+        });
+        slot.queued -= std::min(bytes, slot.queued);
+    }
+
+    expiry_.release();
+}
+
+Host::Slot& Host::getSlot(ENetPeer& peer) noexcept
+{
+    return slots_[size_t(&peer - host_->peers)];
+}
+
 Peer& Host::getPeer(ENetPeer& peer) noexcept
 {
     return peers_[size_t(peer.data)];
 }
 
+Peer* Host::findPeer(ENetPeer& peer) noexcept
+{
+    const auto index = size_t(peer.data);
+    if (index >= peers_.size()) return nullptr;
+    auto& found = peers_[index];
+    return static_cast<ENetPeer*>(found) == &peer ? &found : nullptr;
+}
+
 Peer& Host::createPeer(ENetPeer& peer) noexcept
 {
+    removeDisconnected(); // the slot may be one of them
+    getSlot(peer) = Slot{};
+    congestion_.reset(peer);
+    pacer_.reset(peer);
+    streams_.reset(peer);
+    statefulCompression_.reset(peer);
+    errorCorrection_.reset(peer);
+    table_.setManaged(size_t(&peer - host_->peers), true);
     peer.data = reinterpret_cast<void*>(peers_.size());
     peers_.emplace_back(*this, peer);
     return peers_.back();
@@ -247,6 +998,23 @@ void Host::removePeer(ENetPeer& peer) noexcept
 
     peers_.pop_back();
     peer.data = nullptr;
+    getSlot(peer) = Slot{};
+    scheduler_.clear(peer);
+    congestion_.reset(peer);
+    pacer_.reset(peer);
+    streams_.reset(peer);
+    statefulCompression_.reset(peer);
+    errorCorrection_.reset(peer);
+    table_.setManaged(size_t(&peer - host_->peers), false);
+}
+
+void Host::removeDisconnected() noexcept
+{
+    for (auto peer : disconnected_) {
+        // unless removed already, then its index may belong to another one
+        if (findPeer(*peer)) removePeer(*peer);
+    }
+    disconnected_.clear();
 }
 
 } // \network
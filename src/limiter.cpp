@@ -0,0 +1,136 @@
+#include "wenet/limiter.hpp"
+
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+constexpr auto ProbeLength = 8u;
+constexpr auto InitialLevel = 0.1f; // of a second worth of tokens
+
+constexpr auto PeerKey = uint64_t(1) << 63;
+constexpr auto SourceKey = uint64_t(1) << 62;
+
+size_t roundUp(size_t value) noexcept
+{
+    auto result = size_t(ProbeLength);
+    while (result < value) result <<= 1;
+    return result;
+}
+
+} // \anonymous
+
+RateLimiter::RateLimiter(size_t capacity)
+    : epoch_(Clock::now()), buckets_(roundUp(capacity)) { }
+
+void RateLimiter::setLimit(const Limit& limit) noexcept
+{
+    limit_ = limit;
+    enabled_ = limit.source.packets || limit.source.bytes ||
+               limit.peer.packets || limit.peer.bytes;
+}
+
+bool RateLimiter::intercept(const ENetAddress& address, size_t bytes,
+                            Clock::time_point now) noexcept
+{
+    if (!enabled_) return false;
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    const auto ms = uint32_t(duration_cast<milliseconds>(now - epoch_).count());
+    const auto sourceKey = SourceKey | address.host;
+    const auto peerKey = PeerKey | uint64_t(address.host) << 16 | address.port;
+
+    // both buckets are checked before either is charged, so datagrams one of
+    // them drops do not use up the other
+    auto source = refill(sourceKey, limit_.source, bytes, ms, nullptr);
+    auto peer = refill(peerKey, limit_.peer, bytes, ms, source);
+    if (allows(source, limit_.source, bytes) &&
+        allows(peer, limit_.peer, bytes)) {
+        charge(source, limit_.source, bytes);
+        charge(peer, limit_.peer, bytes);
+        return false;
+    }
+
+    stats_.droppedPackets++;
+    stats_.droppedBytes += bytes;
+    return true;
+}
+
+RateLimiter::Bucket& RateLimiter::find(uint64_t key, const Rate& rate,
+                                       size_t bytes, uint32_t now,
+                                       const Bucket* keep) noexcept
+{
+    const auto mask = buckets_.size() - 1;
+    const auto start = size_t((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+
+    // bounded linear probing, the whole window is searched so reused or
+    // evicted buckets need no tombstones. Empty bucket or the one idle for
+    // the longest time is taken for a new key
+    Bucket* oldest = nullptr;
+    auto oldestAge = uint32_t(0);
+    for (auto i = 0u; i < ProbeLength; ++i) {
+        auto& bucket = buckets_[(start + i) & mask];
+        if (bucket.key == key) return bucket;
+        if (&bucket == keep) continue;
+
+        const auto age = bucket.key ? now - bucket.seen : uint32_t(-1);
+        if (!oldest || age > oldestAge) {
+            oldest = &bucket;
+            oldestAge = age;
+        }
+    }
+
+    // new buckets start low rather than full, otherwise a source evicted by
+    // flooding the table or rotating ports would get its burst back. Enough
+    // for the datagram at hand is let through, so low rates still connect
+    const auto packets = std::max(rate.packets * InitialLevel, 1.0f);
+    const auto initial = std::max(rate.bytes * InitialLevel, float(bytes));
+    *oldest = Bucket{key, now, packets, initial};
+    return *oldest;
+}
+
+RateLimiter::Bucket* RateLimiter::refill(uint64_t key, const Rate& rate,
+                                         size_t bytes, uint32_t now,
+                                         const Bucket* keep) noexcept
+{
+    if (!rate.packets && !rate.bytes) return nullptr;
+
+    auto& bucket = find(key, rate, bytes, now, keep);
+    const auto elapsed = float(now - bucket.seen) / 1000;
+    bucket.seen = now;
+
+    // one second worth of tokens can be accumulated
+    if (rate.packets) {
+        bucket.packets = std::min(bucket.packets + elapsed * rate.packets,
+                                  float(rate.packets));
+    }
+    if (rate.bytes) {
+        bucket.bytes = std::min(bucket.bytes + elapsed * rate.bytes,
+                                float(rate.bytes));
+    }
+    return &bucket;
+}
+
+bool RateLimiter::allows(const Bucket* bucket, const Rate& rate,
+                         size_t bytes) noexcept
+{
+    if (!bucket) return true;
+    if (rate.packets && bucket->packets < 1) return false;
+    return !rate.bytes || bucket->bytes >= bytes;
+}
+
+void RateLimiter::charge(Bucket* bucket, const Rate& rate,
+                         size_t bytes) noexcept
+{
+    if (!bucket) return;
+    if (rate.packets) bucket->packets -= 1;
+    if (rate.bytes) bucket->bytes -= bytes;
+}
+
+} // \wenet
+
+} // \sq
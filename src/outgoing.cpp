@@ -0,0 +1,71 @@
+#include "outgoing.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+namespace outgoing_detail {
+
+template <typename Filter>
+Count count(ENetPeer& peer, Filter&& filter) noexcept
+{
+    Count result;
+    const ENetPacket* last = nullptr;
+    forEach(peer, [&](ENetOutgoingCommand& command) {
+        if (!filter(command)) return;
+        result.bytes += command.fragmentLength;
+        if (command.packet != last) result.packets++;
+        last = command.packet;
+    });
+    return result;
+}
+
+Count count(ENetPeer& peer) noexcept
+{
+    return count(peer, [](const ENetOutgoingCommand&) { return true; });
+}
+
+Count count(ENetPeer& peer, uint8_t channelId) noexcept
+{
+    return count(peer, [channelId](const ENetOutgoingCommand& command) {
+        return command.command.header.channelID == channelId;
+    });
+}
+
+Count countReliable(ENetPeer& peer) noexcept
+{
+    return count(peer, [](const ENetOutgoingCommand& command) {
+        return isReliable(command);
+    });
+}
+
+void release(ENetOutgoingCommand& command) noexcept
+{
+    enet_list_remove(&command.outgoingCommandList);
+
+    auto packet = command.packet;
+    if (packet && !--packet->referenceCount) enet_packet_destroy(packet);
+
+    enet_free(&command);
+}
+
+size_t dropOldestUnreliable(ENetPeer& peer) noexcept
+{
+    size_t bytes = 0;
+    const ENetPacket* oldest = nullptr;
+    forEach(peer, [&](ENetOutgoingCommand& command) {
+        if (isReliable(command)) return;
+        if (oldest && command.packet != oldest) return;
+
+        oldest = command.packet;
+        bytes += command.fragmentLength;
+        release(command);
+    });
+    return bytes;
+}
+
+} // \outgoing_detail
+
+} // \wenet
+
+} // \sq
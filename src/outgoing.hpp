@@ -0,0 +1,78 @@
+#ifndef SQ_WENET_OUTGOING_HPP
+#define SQ_WENET_OUTGOING_HPP
+
+#include "belks/base.hpp"
+
+#include <enet/enet.h>
+
+namespace sq {
+
+namespace wenet {
+
+// Access to commands ENet has queued for a peer but not put on the wire yet
+
+namespace outgoing_detail {
+
+struct Count {
+    size_t bytes = 0;
+    size_t packets = 0;
+};
+
+inline bool isReliable(const ENetOutgoingCommand& command) noexcept
+{
+    return command.command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+}
+
+// ENet sends unreliable packets that do not fit a datagram as reliable
+// fragments unless they are flagged for unreliable fragments
+inline bool isSentReliably(const ENetPeer& peer,
+                           const ENetPacket& packet) noexcept
+{
+    if (packet.flags & ENET_PACKET_FLAG_RELIABLE) return true;
+    if (packet.flags & ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT) return false;
+    return packet.dataLength > peer.mtu - sizeof(ENetProtocolHeader) -
+                               sizeof(ENetProtocolSendFragment);
+}
+
+template <typename F>
+void forEach(ENetPeer& peer, F&& callback)
+{
+#if ENET_VERSION_CREATE(1, 3, 18) <= ENET_VERSION
+    ENetList* lists[] = {
+        &peer.outgoingSendReliableCommands, &peer.outgoingCommands
+    };
+#else
+    ENetList* lists[] = {
+        &peer.outgoingReliableCommands, &peer.outgoingUnreliableCommands
+    };
+#endif
+
+    for (auto list : lists) {
+        auto it = enet_list_begin(list);
+        while (it != enet_list_end(list)) {
+            auto& command = *reinterpret_cast<ENetOutgoingCommand*>(it);
+            it = enet_list_next(it); // callback may release the command
+            if (command.packet) callback(command);
+        }
+    }
+}
+
+// Packets are counted once no matter how many fragments are still queued
+Count count(ENetPeer& peer) noexcept;
+Count count(ENetPeer& peer, uint8_t channelId) noexcept;
+Count countReliable(ENetPeer& peer) noexcept;
+
+// Unlinks command from the queue, frees it and releases its packet
+void release(ENetOutgoingCommand& command) noexcept;
+
+// Removes all queued fragments of the oldest unreliable packet,
+// returns number of payload bytes freed (0 if nothing to drop)
+size_t dropOldestUnreliable(ENetPeer& peer) noexcept;
+
+} // \outgoing_detail
+
+} // \wenet
+
+} // \sq
+
+#endif
@@ -0,0 +1,85 @@
+#include "wenet/pacer.hpp"
+
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+Pacer::Pacer(size_t peerCount) : slots_(peerCount) { }
+
+void Pacer::setSettings(const Settings& settings) noexcept
+{
+    settings_ = settings;
+}
+
+void Pacer::reset(const ENetPeer& peer) noexcept
+{
+    slots_[size_t(&peer - peer.host->peers)] = Bucket{};
+}
+
+size_t Pacer::update(const ENetPeer& peer, Clock::time_point now) noexcept
+{
+    auto& slot = slots_[size_t(&peer - peer.host->peers)];
+    refill(slot, settings_.peer, peer.mtu, now);
+    refill(host_, settings_.host, peer.mtu, now);
+
+    // tokens go negative when a packet overshoots them
+    auto tokens = double(size_t(-1));
+    if (settings_.peer) tokens = std::min(tokens, slot.tokens);
+    if (settings_.host) tokens = std::min(tokens, host_.tokens);
+    return tokens > 0 ? size_t(tokens) : 0;
+}
+
+void Pacer::onSent(const ENetPeer& peer, size_t bytes,
+                   Clock::time_point now) noexcept
+{
+    if (!bytes) return;
+    take(slots_[size_t(&peer - peer.host->peers)], bytes, now);
+    take(host_, bytes, now);
+}
+
+Pacer::Gaps Pacer::getGaps(const ENetPeer& peer) const noexcept
+{
+    return toGaps(slots_[size_t(&peer - peer.host->peers)]);
+}
+
+void Pacer::refill(Bucket& bucket, speed::bs rate, size_t mtu,
+                   Clock::time_point now) const noexcept
+{
+    // a bucket starts full and holds at least a packet
+    const auto burst = std::max(
+        double(rate) * settings_.burst.count() / 1000000, double(mtu)
+    );
+    if (bucket.refill == Clock::time_point{}) bucket.tokens = burst;
+    else {
+        const auto elapsed = std::chrono::duration<double>(now - bucket.refill);
+        bucket.tokens = std::min(bucket.tokens + rate * elapsed.count(),
+                                 burst);
+    }
+    bucket.refill = now;
+}
+
+void Pacer::take(Bucket& bucket, size_t bytes, Clock::time_point now) noexcept
+{
+    bucket.tokens -= bytes;
+
+    if (bucket.sent != Clock::time_point{}) {
+        using us = std::chrono::duration<double, std::micro>;
+        bucket.last = us(now - bucket.sent).count();
+        bucket.average = bucket.average ? bucket.average * 0.875 +
+                                          bucket.last * 0.125 : bucket.last;
+    }
+    bucket.sent = now;
+}
+
+Pacer::Gaps Pacer::toGaps(const Bucket& bucket) noexcept
+{
+    return {
+        time::us{uint32_t(bucket.last)}, time::us{uint32_t(bucket.average)}
+    };
+}
+
+} // \wenet
+
+} // \sq
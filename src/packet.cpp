@@ -26,6 +26,8 @@ Packet::Flags convertFlags(Packet::Flags flags)
     return flags & ~Packet::Flag::Unreliable; // unreliable is a dummy flag
 }
 
+constexpr uint64_t Packet::NoKey;
+
 // ENetPacket Deleter
 
 void Packet::Deleter::operator () (ENetPacket* packet) const noexcept
@@ -47,6 +49,17 @@ Packet::Packet(size_t size, Flag flag)
 Packet::Packet(size_t size, Flags flags) noexcept
     : Packet(*enet_packet_create(nullptr, size, convertFlags(flags))) { }
 
+Packet::Packet(const SharedBuffer& buffer, Flag flag)
+    : Packet(buffer, belks::underlying_cast(flag)) { }
+
+Packet::Packet(const SharedBuffer& buffer, Flags flags)
+{
+    if (!buffer.isInit()) throw UninitialisedException{"Buffer is empty"};
+
+    packetOwned_.reset(&buffer.createPacket(convertFlags(flags)));
+    packet_ = packetOwned_.get();
+}
+
 Packet::Packet(ENetPacket& packet, bool manage) noexcept
     : packet_(&packet), packetOwned_(manage ? &packet : nullptr) { }
 
@@ -80,23 +93,6 @@ const Packet& Packet::operator << (span<const byte> data) const
     return *this;
 }
 
-void Packet::onDestroy(const FreeCallback& callback) const noexcept
-{
-    if (packet_->userData) {
-        delete reinterpret_cast<FreeCallback*>(packet_->userData);
-        packet_->userData = nullptr;
-        packet_->freeCallback = nullptr;
-    }
-    if (callback) {
-        packet_->userData = new FreeCallback(callback);
-        packet_->freeCallback = [](ENetPacket* packet) {
-            const auto callback = reinterpret_cast<FreeCallback*>(packet->userData);
-            (*callback)({*packet, false});
-            delete reinterpret_cast<FreeCallback*>(packet->userData);
-        };
-    }
-}
-
 void Packet::setFlags(Flags flags) const
 {
     throwIfLocked();
@@ -115,6 +111,16 @@ void Packet::resize(size_t size) const
     else enet_packet_resize(packet_, size);
 }
 
+void Packet::setDeadline(Clock::time_point deadline) noexcept
+{
+    deadline_ = deadline;
+}
+
+void Packet::setTtl(time::ms ttl) noexcept
+{
+    deadline_ = Clock::now() + ttl;
+}
+
 span<byte> Packet::getData() const noexcept
 {
     return {packet_->data, std::ptrdiff_t(packet_->dataLength)};
@@ -2,6 +2,10 @@
 
 #include "wenet/host.hpp"
 
+#include "outgoing.hpp"
+
+#include <numeric>
+
 namespace sq {
 
 namespace wenet {
@@ -65,16 +69,80 @@ void Peer::receive(Callback callback) const noexcept
 
 // Send
 
-void Peer::send(Packet& packet, uint8_t channelId) const noexcept
+// Packet copied for the peer (stateful compression, error correction) is not
+// referenced by ENet and stays with its owner
+
+bool Peer::send(Packet& packet, uint8_t channelId) const noexcept
+{
+    if (!host_->enqueue(*peer_, channelId, packet)) return false;
+    const auto taken = static_cast<ENetPacket*>(packet)->referenceCount;
+    if (packet.isOwned() && taken) packet.releaseOwnership();
+    return true;
+}
+
+bool Peer::send(Packet&& packet, uint8_t channelId) const noexcept
+{
+    if (!host_->enqueue(*peer_, channelId, packet)) return false;
+    if (static_cast<ENetPacket*>(packet)->referenceCount) {
+        packet.releaseOwnership();
+    }
+    return true;
+}
+
+bool Peer::send(Packet& packet, uint8_t channelId,
+                time::ms ttl) const noexcept
+{
+    packet.setTtl(ttl);
+    return send(packet, channelId);
+}
+
+bool Peer::send(Packet&& packet, uint8_t channelId,
+                time::ms ttl) const noexcept
+{
+    packet.setTtl(ttl);
+    return send(std::move(packet), channelId);
+}
+
+uint32_t Peer::sendStream(cstring_span<> path, span<const byte> info) const
+{
+    return host_->streams_.send(*peer_, path, info);
+}
+
+// Queue
+
+Peer::Queue Peer::getQueue() const noexcept
+{
+    const auto count = outgoing_detail::count(*peer_);
+    const auto scheduled = host_->scheduler_.count(*peer_);
+    return Queue{
+        count.bytes + scheduled.bytes, count.packets + scheduled.packets
+    };
+}
+
+Peer::Queue Peer::getQueue(uint8_t channelId) const noexcept
+{
+    const auto count = outgoing_detail::count(*peer_, channelId);
+    const auto scheduled = host_->scheduler_.count(*peer_, channelId);
+    return Queue{
+        count.bytes + scheduled.bytes, count.packets + scheduled.packets
+    };
+}
+
+size_t Peer::getDroppedPackets() const noexcept
 {
-    if (packet.isOwned()) packet.releaseOwnership();
-    enet_peer_send(peer_, channelId, packet);
+    return host_->getSlot(*peer_).dropped;
 }
 
-void Peer::send(Packet&& packet, uint8_t channelId) const noexcept
+size_t Peer::getExpiredPackets() const noexcept
 {
-    packet.releaseOwnership();
-    enet_peer_send(peer_, channelId, packet);
+    const auto& expired = host_->getSlot(*peer_).expired;
+    return std::accumulate(expired.begin(), expired.end(), size_t(0));
+}
+
+size_t Peer::getExpiredPackets(uint8_t channelId) const noexcept
+{
+    const auto& expired = host_->getSlot(*peer_).expired;
+    return channelId < expired.size() ? expired[channelId] : 0;
 }
 
 // Throttle
@@ -138,6 +206,31 @@ uint32_t Peer::getPacketLoss() const noexcept
     return peer_->packetLoss;
 }
 
+// Congestion control
+
+speed::bs Peer::getEstimatedBandwidth() const noexcept
+{
+    return host_->congestion_.getBandwidth(*peer_);
+}
+
+speed::bs Peer::getPacingRate() const noexcept
+{
+    if (!host_->congestionControl_) return 0;
+    return host_->congestion_.getPacingRate(*peer_);
+}
+
+time::ms Peer::getMinRoundTripTime() const noexcept
+{
+    return host_->congestion_.getMinRoundTripTime(*peer_);
+}
+
+// Send pacing
+
+Pacer::Gaps Peer::getPacingGaps() const noexcept
+{
+    return host_->pacer_.getGaps(*peer_);
+}
+
 } // \wenet
 
 } // \sq
@@ -0,0 +1,169 @@
+#include "wenet/pool.hpp"
+
+#include <limits>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+uint64_t pack(uint64_t begin, uint64_t end) noexcept
+{
+    return begin << 32 | end;
+}
+
+uint32_t getBegin(uint64_t bounds) noexcept { return uint32_t(bounds >> 32); }
+uint32_t getEnd(uint64_t bounds) noexcept { return uint32_t(bounds); }
+
+size_t getDefaultThreads() noexcept
+{
+    const auto cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+} // \anonymous
+
+WorkPool::WorkPool() : WorkPool(getDefaultThreads()) { }
+
+WorkPool::WorkPool(size_t threads) : slices_(new Slice[threads + 1])
+{
+    threads_.reserve(threads);
+    for (auto i = size_t(0); i < threads; ++i) {
+        threads_.emplace_back(&WorkPool::loop, this, i + 1);
+    }
+}
+
+WorkPool::~WorkPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+void WorkPool::run(size_t count, const Task& task)
+{
+    if (!count) return;
+    if (count > std::numeric_limits<uint32_t>::max()) {
+        throw Exception{"Too many indices"};
+    }
+
+    const auto workers = threads_.size() + 1;
+    for (auto i = size_t(0); i < workers; ++i) {
+        const auto begin = count * i / workers;
+        const auto end = count * (i + 1) / workers;
+        slices_[i].bounds.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        task_ = &task;
+        working_ = threads_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait(lock, [&] { return !working_; });
+    task_ = nullptr;
+
+    if (error_) {
+        auto error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkPool::loop(size_t worker)
+{
+    auto generation = size_t(0);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            wake_.wait(lock, [&] {
+                return stop_ || generation_ != generation;
+            });
+            if (stop_) return;
+            generation = generation_;
+        }
+
+        work(worker);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!--working_) done_.notify_one();
+    }
+}
+
+void WorkPool::work(size_t worker) noexcept
+{
+    do {
+        auto index = size_t(0);
+        while (take(worker, index)) {
+            try {
+                (*task_)(index);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (!error_) error_ = std::current_exception();
+            }
+        }
+    } while (steal(worker));
+}
+
+bool WorkPool::take(size_t worker, size_t& index) noexcept
+{
+    auto& bounds = slices_[worker].bounds;
+    auto value = bounds.load(std::memory_order_acquire);
+    do {
+        if (getBegin(value) >= getEnd(value)) return false;
+    } while (!bounds.compare_exchange_weak(
+        value, pack(getBegin(value) + 1, getEnd(value)),
+        std::memory_order_acq_rel, std::memory_order_acquire
+    ));
+
+    index = getBegin(value);
+    return true;
+}
+
+bool WorkPool::steal(size_t worker) noexcept
+{
+    const auto workers = threads_.size() + 1;
+    for (;;) {
+        // largest slice left is the one least likely to run out meanwhile
+        auto victim = workers;
+        auto value = uint64_t(0);
+        auto largest = uint32_t(0);
+        for (auto i = size_t(0); i < workers; ++i) {
+            const auto bounds = slices_[i].bounds.load(
+                std::memory_order_acquire
+            );
+            const auto left = getEnd(bounds) - getBegin(bounds);
+            if (getBegin(bounds) < getEnd(bounds) && left > largest) {
+                victim = i;
+                value = bounds;
+                largest = left;
+            }
+        }
+        if (victim == workers) return false;
+
+        // owner keeps taking from the front, the back half moves here
+        const auto middle = getEnd(value) - (largest + 1) / 2;
+        if (slices_[victim].bounds.compare_exchange_strong(
+                value, pack(getBegin(value), middle),
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            slices_[worker].bounds.store(pack(middle, getEnd(value)),
+                                         std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,34 @@
+#include "wenet/router.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+void Router::add(uint8_t channelId, uint8_t messageId, Handler handler,
+                 void* context)
+{
+    auto& table = tables_[channelId];
+    if (!table) table = std::make_unique<Table>(Table{});
+    (*table)[messageId] = {handler, context};
+}
+
+void Router::remove(uint8_t channelId, uint8_t messageId) noexcept
+{
+    auto& table = tables_[channelId];
+    if (table) (*table)[messageId] = {nullptr, nullptr};
+}
+
+bool Router::dispatch(Peer& peer, Packet& packet, uint8_t channelId) const
+{
+    const auto& table = tables_[channelId];
+    if (!table || !packet.getSize()) return false;
+
+    const auto& entry = (*table)[packet.getData()[0]];
+    if (!entry.handler) return false;
+    entry.handler(entry.context, peer, std::move(packet));
+    return true;
+}
+
+} // \wenet
+
+} // \sq
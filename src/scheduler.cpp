@@ -0,0 +1,301 @@
+#include "wenet/scheduler.hpp"
+
+#include "outgoing.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace sq {
+
+namespace wenet {
+
+ENetPacket& ChannelScheduler::Lane::pop() noexcept
+{
+    auto& packet = *entries[head].packet;
+    bytes -= packet.dataLength;
+
+    if (++head == entries.size()) reset();
+    else if (head > 64 && head * 2 > entries.size()) {
+        entries.erase(entries.begin(), entries.begin() + head);
+        head = 0;
+    }
+    return packet;
+}
+
+ChannelScheduler::Entry*
+ChannelScheduler::Lane::find(uint64_t sequence) noexcept
+{
+    // entries are ordered by sequence
+    const auto it = std::lower_bound(
+        entries.begin() + head, entries.end(), sequence,
+        [](const Entry& entry, uint64_t value) {
+            return entry.sequence < value;
+        }
+    );
+    return it != entries.end() && it->sequence == sequence ? &*it : nullptr;
+}
+
+void ChannelScheduler::Lane::reset() noexcept
+{
+    entries.clear();
+    keys.clear();
+    head = 0;
+}
+
+ChannelScheduler::ChannelScheduler(size_t peerCount) : slots_(peerCount)
+{
+    priorities_.fill(Priority{0, 1});
+}
+
+ChannelScheduler::~ChannelScheduler() noexcept
+{
+    for (auto& slot : slots_) {
+        for (auto& lane : slot.lanes) {
+            while (!lane.empty()) release(lane.pop());
+        }
+    }
+}
+
+ChannelScheduler::Priority
+ChannelScheduler::getPriority(uint8_t channelId) const noexcept
+{
+    return priorities_[channelId];
+}
+
+void ChannelScheduler::setPriority(uint8_t channelId,
+                                   const Priority& priority) noexcept
+{
+    priorities_[channelId] = {priority.level, std::max(priority.weight, 1u)};
+    enabled_ = true;
+}
+
+void ChannelScheduler::setKeyed(uint8_t channelId, bool keyed) noexcept
+{
+    keyed_[channelId] = keyed;
+    if (keyed) enabled_ = true;
+}
+
+void ChannelScheduler::push(ENetPeer& peer, uint8_t channelId,
+                            ENetPacket& packet)
+{
+    auto& slot = getSlot(peer);
+    if (slot.lanes.size() < peer.channelCount) {
+        slot.lanes.resize(peer.channelCount);
+    }
+
+    auto& lane = slot.lanes[channelId];
+    lane.entries.push_back({&packet, sequence_++});
+    lane.bytes += packet.dataLength;
+    slot.packets++;
+    packet.referenceCount++;
+}
+
+size_t ChannelScheduler::push(ENetPeer& peer, uint8_t channelId,
+                              ENetPacket& packet, uint64_t key)
+{
+    if (!keyed_[channelId]) {
+        push(peer, channelId, packet);
+        return 0;
+    }
+
+    auto& slot = getSlot(peer);
+    if (channelId < slot.lanes.size()) {
+        auto& lane = slot.lanes[channelId];
+        const auto it = lane.keys.find(key);
+        auto entry = it != lane.keys.end() ? lane.find(it->second) : nullptr;
+        if (entry) {
+            // replaced in place, so it goes out no later than the old one
+            auto& old = *entry->packet;
+            const auto size = old.dataLength;
+            lane.bytes = lane.bytes - size + packet.dataLength;
+            entry->packet = &packet;
+            packet.referenceCount++;
+            release(old);
+            return size;
+        }
+    }
+
+    const auto sequence = sequence_;
+    push(peer, channelId, packet);
+
+    // keys of packets sent already are forgotten once they pile up
+    auto& lane = slot.lanes[channelId];
+    const auto queued = lane.entries.size() - lane.head;
+    if (lane.keys.size() > 2 * queued + 64) {
+        for (auto it = lane.keys.begin(); it != lane.keys.end();) {
+            if (lane.find(it->second)) ++it;
+            else it = lane.keys.erase(it);
+        }
+    }
+    lane.keys[key] = sequence;
+    return 0;
+}
+
+size_t ChannelScheduler::drain(ENetPeer& peer, size_t limit) noexcept
+{
+    size_t reliable, refused;
+    return drain(peer, limit, reliable, refused);
+}
+
+size_t ChannelScheduler::drain(ENetPeer& peer, size_t limit,
+                               size_t& reliable, size_t& refused) noexcept
+{
+    reliable = 0;
+    refused = 0;
+    auto& slot = getSlot(peer);
+    if (!slot.packets || !limit) return 0;
+
+    // same window ENet applies to reliable data, bytes it holds already
+    // count against it. One packet may exceed the window if nothing is in
+    // flight so large packets cannot get stuck
+    const size_t window = std::max(peer.packetThrottle * peer.windowSize /
+                                   ENET_PEER_PACKET_THROTTLE_SCALE, peer.mtu);
+    const auto queued = outgoing_detail::count(peer).bytes;
+    const auto inFlight = peer.reliableDataInTransit + queued;
+    auto budget = window > inFlight ? window - inFlight : 0;
+    auto idle = !inFlight;
+    size_t sent = 0;
+
+    const auto channels = slot.lanes.size();
+    std::array<uint8_t, 256> order;
+    std::iota(order.begin(), order.begin() + channels, 0);
+    std::stable_sort(order.begin(), order.begin() + channels,
+                     [this](uint8_t a, uint8_t b) {
+                         return priorities_[a].level > priorities_[b].level;
+                     });
+
+    // strict priority between levels, deficit round robin within a level
+    for (auto begin = 0u; begin < channels;) {
+        const auto level = priorities_[order[begin]].level;
+        auto end = begin;
+        while (end < channels && priorities_[order[end]].level == level) end++;
+
+        for (auto pending = true; pending;) {
+            pending = false;
+            for (auto i = begin; i < end; ++i) {
+                const auto channelId = order[i];
+                auto& lane = slot.lanes[channelId];
+                if (lane.empty()) {
+                    lane.deficit = 0;
+                    continue;
+                }
+
+                lane.deficit += peer.mtu * priorities_[channelId].weight;
+                while (!lane.empty()) {
+                    auto& packet = *lane.front().packet;
+                    const auto size = packet.dataLength;
+                    if (size > lane.deficit) break;
+                    if (size > budget && !idle) return sent;
+                    if (!limit) return sent;
+
+                    const auto taken = !enet_peer_send(&peer, channelId,
+                                                       &lane.pop());
+                    if (taken &&
+                        outgoing_detail::isSentReliably(peer, packet)) {
+                        reliable += size;
+                    }
+                    release(packet);
+                    slot.packets--;
+                    if (!taken) {
+                        // too large or the peer is gone, not sent at all
+                        refused++;
+                        continue;
+                    }
+
+                    lane.deficit -= size;
+                    budget -= std::min(size, budget);
+                    limit -= std::min(size, limit);
+                    idle = false;
+                    sent += size;
+                }
+                pending = pending || !lane.empty();
+            }
+        }
+        begin = end;
+    }
+    return sent;
+}
+
+void ChannelScheduler::clear(ENetPeer& peer) noexcept
+{
+    auto& slot = getSlot(peer);
+    for (auto& lane : slot.lanes) {
+        while (!lane.empty()) release(lane.pop());
+        lane.deficit = 0;
+        lane.keys.clear();
+    }
+    slot.packets = 0;
+}
+
+size_t ChannelScheduler::dropOldestUnreliable(ENetPeer& peer) noexcept
+{
+    auto& slot = getSlot(peer);
+
+    Lane* oldestLane = nullptr;
+    size_t oldest = 0;
+    for (auto& lane : slot.lanes) {
+        for (auto i = lane.head; i < lane.entries.size(); ++i) {
+            const auto& entry = lane.entries[i];
+            if (entry.packet->flags & ENET_PACKET_FLAG_RELIABLE) continue;
+            if (!oldestLane ||
+                entry.sequence < oldestLane->entries[oldest].sequence) {
+                oldestLane = &lane;
+                oldest = i;
+            }
+            break; // entries in a lane are ordered by sequence
+        }
+    }
+    if (!oldestLane) return 0;
+
+    // move it to the front keeping the rest in order
+    auto& lane = *oldestLane;
+    std::rotate(lane.entries.begin() + lane.head,
+                lane.entries.begin() + oldest,
+                lane.entries.begin() + oldest + 1);
+
+    auto& packet = lane.pop();
+    const auto size = packet.dataLength;
+    release(packet);
+    slot.packets--;
+    return size;
+}
+
+ChannelScheduler::Count
+ChannelScheduler::count(const ENetPeer& peer) const noexcept
+{
+    auto& slot = getSlot(peer);
+
+    Count result{0, slot.packets};
+    for (auto& lane : slot.lanes) result.bytes += lane.bytes;
+    return result;
+}
+
+ChannelScheduler::Count
+ChannelScheduler::count(const ENetPeer& peer, uint8_t channelId) const noexcept
+{
+    auto& slot = getSlot(peer);
+    if (channelId >= slot.lanes.size()) return {0, 0};
+
+    auto& lane = slot.lanes[channelId];
+    return {lane.bytes, lane.entries.size() - lane.head};
+}
+
+ChannelScheduler::Slot& ChannelScheduler::getSlot(const ENetPeer& peer) noexcept
+{
+    return slots_[size_t(&peer - peer.host->peers)];
+}
+
+const ChannelScheduler::Slot&
+ChannelScheduler::getSlot(const ENetPeer& peer) const noexcept
+{
+    return slots_[size_t(&peer - peer.host->peers)];
+}
+
+void ChannelScheduler::release(ENetPacket& packet) noexcept
+{
+    if (!--packet.referenceCount) enet_packet_destroy(&packet);
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,292 @@
+#include "wenet/stream.hpp"
+
+#include "wenet/host.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+// Stream header: marker, id and 64 bit size (network byte order) followed
+// by user info. Chunks carry raw data only, reliable ordered delivery on the
+// stream channel tells receiver where they belong
+constexpr byte Marker = 0x53;
+constexpr auto HeaderSize = 1u + 4u + 8u;
+
+void write32(byte* out, uint32_t value) noexcept
+{
+    for (auto i = 0; i < 4; ++i) out[i] = byte(value >> (24 - i * 8));
+}
+
+uint32_t read32(const byte* in) noexcept
+{
+    uint32_t value = 0;
+    for (auto i = 0; i < 4; ++i) value = value << 8 | in[i];
+    return value;
+}
+
+} // \anonymous
+
+// MappedFile
+
+MappedFile::MappedFile(cstring_span<> path)
+{
+    fd_ = open(gsl::to_string(path).c_str(), O_RDONLY);
+    if (fd_ < 0) throw Exception{"Cannot open file"};
+
+    struct stat info;
+    if (fstat(fd_, &info)) {
+        close(fd_);
+        throw Exception{"Cannot get file size"};
+    }
+    size_ = info.st_size;
+
+    map(PROT_READ, MAP_PRIVATE);
+    if (data_) madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::MappedFile(cstring_span<> path, size_t size) : size_(size)
+{
+    fd_ = open(gsl::to_string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw Exception{"Cannot create file"};
+
+    if (ftruncate(fd_, size)) {
+        close(fd_);
+        throw Exception{"Cannot resize file"};
+    }
+
+    map(PROT_READ | PROT_WRITE, MAP_SHARED);
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    if (data_) munmap(data_, size_);
+    close(fd_);
+}
+
+span<byte> MappedFile::getData() const noexcept
+{
+    return {data_, std::ptrdiff_t(size_)};
+}
+
+void MappedFile::map(int protection, int flags)
+{
+    if (!size_) return; // empty files cannot be mapped
+
+    auto data = mmap(nullptr, size_, protection, flags, fd_, 0);
+    if (data == MAP_FAILED) {
+        close(fd_);
+        throw Exception{"Cannot map file"};
+    }
+    data_ = static_cast<byte*>(data);
+}
+
+// IncomingStream
+
+void IncomingStream::accept(span<byte> destination)
+{
+    if (size_t(destination.size()) < size_) {
+        throw Streams::Exception{"Destination is too small"};
+    }
+    destination_ = destination;
+}
+
+void IncomingStream::accept(cstring_span<> path)
+{
+    file_ = std::make_unique<MappedFile>(path, size_);
+    destination_ = file_->getData();
+}
+
+// Streams
+
+Streams::Streams(Host& host, size_t peerCount)
+    : host_(&host), incoming_(peerCount) { }
+
+Streams::~Streams() noexcept = default;
+
+void Streams::setChannel(uint8_t channelId) noexcept
+{
+    channelId_ = channelId;
+    enabled_ = true;
+}
+
+void Streams::setWindow(const Window& window) noexcept
+{
+    window_ = {std::max<size_t>(window.chunkSize, 1),
+               std::max<size_t>(window.chunks, 1)};
+}
+
+void Streams::onBegin(BeginCallback callback) noexcept
+{
+    cbBegin_ = std::move(callback);
+}
+
+void Streams::onSent(ProgressCallback callback) noexcept
+{
+    cbSent_ = std::move(callback);
+}
+
+void Streams::onReceived(ProgressCallback callback) noexcept
+{
+    cbReceived_ = std::move(callback);
+}
+
+uint32_t Streams::send(ENetPeer& peer, cstring_span<> path,
+                       span<const byte> info)
+{
+    if (!enabled_) throw Exception{"Stream channel is not set"};
+
+    outgoing_.push_back(std::make_unique<Outgoing>(peer, nextId_, path, info));
+    return nextId_++;
+}
+
+void Streams::pump()
+{
+    // streams to the same peer go one after another, the next one begins
+    // once all chunks of the previous one are queued
+    std::vector<const ENetPeer*> busy;
+
+    for (auto& stream : outgoing_) {
+        auto& peer = *stream->peer;
+        if (stream->aborted) continue;
+        if (peer.state != ENET_PEER_STATE_CONNECTED) continue;
+
+        const auto size = stream->file.getSize();
+        if (stream->sent < size || !stream->begun) {
+            auto found = std::find(busy.begin(), busy.end(), &peer);
+            if (found != busy.end()) continue;
+            busy.push_back(&peer);
+        }
+
+        if (!stream->begun && !begin(*stream)) continue;
+        while (stream->sent < size && stream->outstanding < window_.chunks) {
+            if (!sendChunk(*stream)) break;
+        }
+
+        if (stream->acked != stream->reported || !size) {
+            stream->reported = stream->acked;
+            if (cbSent_) {
+                cbSent_(host_->getPeer(peer),
+                        {stream->id, stream->acked, size});
+            }
+        }
+    }
+
+    // ENet no longer refers to finished or aborted streams
+    outgoing_.erase(std::remove_if(outgoing_.begin(), outgoing_.end(),
+        [](const std::unique_ptr<Outgoing>& stream) {
+            const auto done = stream->begun &&
+                              stream->acked >= stream->file.getSize();
+            return (done || stream->aborted) && !stream->outstanding;
+        }), outgoing_.end());
+}
+
+void Streams::receive(ENetPeer& peer, const Packet& packet)
+{
+    auto& stream = getIncoming(peer);
+    const auto data = packet.getData();
+
+    if (!stream.active_) {
+        if (size_t(data.size()) < HeaderSize || data[0] != Marker) return;
+
+        stream = IncomingStream{};
+        stream.active_ = true;
+        stream.id_ = read32(&data[1]);
+        stream.size_ = size_t(read32(&data[5])) << 32 | read32(&data[9]);
+        stream.info_.assign(data.begin() + HeaderSize, data.end());
+
+        if (cbBegin_) cbBegin_(host_->getPeer(peer), stream);
+    }
+    else {
+        const auto length = std::min(size_t(data.size()),
+                                     stream.size_ - stream.received_);
+        if (stream.isAccepted()) {
+            std::copy(data.begin(), data.begin() + length,
+                      stream.destination_.begin() + stream.received_);
+        }
+        stream.received_ += length;
+    }
+
+    if (stream.isAccepted() && cbReceived_) {
+        cbReceived_(host_->getPeer(peer),
+                    {stream.id_, stream.received_, stream.size_});
+    }
+    if (stream.received_ >= stream.size_) stream = IncomingStream{};
+}
+
+void Streams::reset(ENetPeer& peer) noexcept
+{
+    getIncoming(peer) = IncomingStream{};
+    for (auto& stream : outgoing_) {
+        if (stream->peer == &peer) stream->aborted = true;
+    }
+}
+
+bool Streams::begin(Outgoing& stream)
+{
+    Packet packet{HeaderSize + stream.info.size()};
+    auto data = packet.getData();
+    data[0] = Marker;
+    write32(&data[1], stream.id);
+    write32(&data[5], uint64_t(stream.file.getSize()) >> 32);
+    write32(&data[9], uint32_t(stream.file.getSize()));
+    std::copy(stream.info.begin(), stream.info.end(), &data[HeaderSize]);
+
+    auto& header = *static_cast<ENetPacket*>(packet);
+    if (!host_->submit(*stream.peer, channelId_, header)) {
+        stream.aborted = true;
+        return false;
+    }
+    packet.releaseOwnership();
+    stream.begun = true;
+    return true;
+}
+
+bool Streams::sendChunk(Outgoing& stream)
+{
+    const auto size = std::min(window_.chunkSize,
+                               stream.file.getSize() - stream.sent);
+    auto data = &stream.file.getData()[0] + stream.sent;
+
+    const auto flags = ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_NO_ALLOCATE;
+    auto& packet = *enet_packet_create(data, size, flags);
+    packet.userData = &stream;
+    packet.freeCallback = onChunkFree;
+    stream.outstanding++;
+
+    if (!host_->submit(*stream.peer, channelId_, packet)) {
+        enet_packet_destroy(&packet);
+        stream.aborted = true;
+        return false;
+    }
+    stream.sent += size;
+    return true;
+}
+
+IncomingStream& Streams::getIncoming(const ENetPeer& peer) noexcept
+{
+    return incoming_[size_t(&peer - peer.host->peers)];
+}
+
+void Streams::onChunkFree(ENetPacket* packet)
+{
+    // ENet marks packets it has acknowledged, chunks released by reset,
+    // disconnect or a failed submit were never delivered
+    auto& stream = *static_cast<Outgoing*>(packet->userData);
+    if (packet->flags & ENET_PACKET_FLAG_SENT) {
+        stream.acked += packet->dataLength;
+    }
+    stream.outstanding--;
+}
+
+} // \wenet
+
+} // \sq
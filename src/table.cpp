@@ -0,0 +1,106 @@
+#include "wenet/table.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+// Appends index of every selected entry without branching on the selection
+template <typename Select>
+void select(size_t size, PeerTable::Slots& slots, Select select)
+{
+    slots.resize(size);
+    auto count = size_t(0);
+    for (auto i = size_t(0); i < size; ++i) {
+        slots[count] = uint32_t(i);
+        count += select(i);
+    }
+    slots.resize(count);
+}
+
+} // \anonymous
+
+PeerTable::PeerTable(size_t peerCount)
+    : states_(peerCount), managed_(peerCount), active_(peerCount)
+{
+    for (auto& metric : metrics_) metric.resize(peerCount);
+}
+
+void PeerTable::refresh(const ENetHost& host) noexcept
+{
+    auto& rtt = getColumn(Metric::RoundTripTime);
+    auto& loss = getColumn(Metric::PacketLoss);
+    auto& incoming = getColumn(Metric::IncomingBandwidth);
+    auto& outgoing = getColumn(Metric::OutgoingBandwidth);
+
+    // the one pass that touches every ENetPeer, queries only read columns
+    for (auto i = size_t(0); i < host.peerCount; ++i) {
+        const auto& peer = host.peers[i];
+        states_[i] = uint8_t(peer.state);
+        rtt[i] = peer.roundTripTime;
+        loss[i] = peer.packetLoss;
+        incoming[i] = peer.incomingBandwidth;
+        outgoing[i] = peer.outgoingBandwidth;
+        active_[i] = managed_[i] & (peer.state == ENET_PEER_STATE_CONNECTED);
+    }
+}
+
+void PeerTable::setManaged(size_t slot, bool managed) noexcept
+{
+    managed_[slot] = managed;
+    active_[slot] &= uint8_t(managed);
+}
+
+span<const uint8_t> PeerTable::getStates() const noexcept
+{
+    return {states_.data(), std::ptrdiff_t(states_.size())};
+}
+
+span<const uint32_t> PeerTable::get(Metric metric) const noexcept
+{
+    const auto& column = metrics_[size_t(metric)];
+    return {column.data(), std::ptrdiff_t(column.size())};
+}
+
+void PeerTable::findAbove(Metric metric, uint32_t threshold,
+                          Slots& slots) const
+{
+    const auto values = metrics_[size_t(metric)].data();
+    const auto active = active_.data();
+    select(getSize(), slots, [&](size_t i) {
+        return active[i] & (values[i] > threshold);
+    });
+}
+
+void PeerTable::findBelow(Metric metric, uint32_t threshold,
+                          Slots& slots) const
+{
+    const auto values = metrics_[size_t(metric)].data();
+    const auto active = active_.data();
+    select(getSize(), slots, [&](size_t i) {
+        return active[i] & (values[i] < threshold);
+    });
+}
+
+size_t PeerTable::countAbove(Metric metric,
+                             uint32_t threshold) const noexcept
+{
+    const auto values = metrics_[size_t(metric)].data();
+    const auto active = active_.data();
+    const auto size = getSize();
+    auto count = uint32_t(0);
+    for (auto i = size_t(0); i < size; ++i) {
+        count += active[i] & (values[i] > threshold);
+    }
+    return count;
+}
+
+std::vector<uint32_t>& PeerTable::getColumn(Metric metric) noexcept
+{
+    return metrics_[size_t(metric)];
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,220 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using namespace std::chrono_literals;
+
+constexpr auto port = 1253u;
+
+// Loopback address of a client, every one of them is received by the same
+// socket bound to any address
+ENetAddress makeAddress(size_t index)
+{
+    ENetAddress address{};
+    const auto ip = "127.1." + std::to_string(index / 250) + "." +
+                    std::to_string(index % 250 + 1);
+    enet_address_set_host(&address, ip.c_str());
+    address.port = port;
+    return address;
+}
+
+// Datagrams are handed to Admission just like ENet's intercept callback
+// would hand them, its answers go out through the host's socket
+class Server {
+public:
+    Server()
+    {
+        host_.socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+        admission.setEnabled(true);
+    }
+
+    ~Server() { enet_socket_destroy(host_.socket); }
+
+    bool deliver(const ENetAddress& address, std::vector<byte> data,
+                 Admission::Clock::time_point now)
+    {
+        host_.receivedAddress = address;
+        host_.receivedData = data.data();
+        host_.receivedDataLength = data.size();
+        return admission.intercept(host_, now);
+    }
+
+    bool connect(const ENetAddress& address, Admission::Clock::time_point now)
+    {
+        // no peer id, as it is sent by ENet in the first datagram
+        return deliver(address, {0x0F, 0xFF, 0x00, 0x00}, now);
+    }
+
+    bool echo(const ENetAddress& address, uint64_t cookie,
+              Admission::Clock::time_point now)
+    {
+        std::vector<byte> data{'W', 'N', 'C', '!'};
+        for (auto i = 0u; i < 8; ++i) data.push_back(byte(cookie >> i * 8));
+        return deliver(address, std::move(data), now);
+    }
+
+    Admission admission;
+
+private:
+    ENetHost host_{};
+};
+
+class Clients {
+public:
+    Clients()
+    {
+        socket_ = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+        ENetAddress address{ENET_HOST_ANY, port};
+        enet_socket_bind(socket_, &address);
+    }
+
+    ~Clients() { enet_socket_destroy(socket_); }
+
+    // Cookie of the next challenge, 0 if none arrives
+    uint64_t receiveCookie()
+    {
+        auto condition = enet_uint32(ENET_SOCKET_WAIT_RECEIVE);
+        if (enet_socket_wait(socket_, &condition, 1000) || !condition) return 0;
+
+        byte message[64];
+        ENetAddress address;
+        ENetBuffer buffer{message, sizeof(message)};
+        if (enet_socket_receive(socket_, &address, &buffer, 1) != 12) return 0;
+        if (message[0] != 'W' || message[3] != '?') return 0;
+
+        auto cookie = uint64_t(0);
+        for (auto i = 0u; i < 8; ++i) {
+            cookie |= uint64_t(message[4 + i]) << i * 8;
+        }
+        return cookie;
+    }
+
+private:
+    ENetSocket socket_;
+};
+
+SCENARIO( "Admission", "[wenet][admission]" ) {
+    Server server;
+    Clients clients;
+    const auto client = makeAddress(0);
+    const auto now = Admission::Clock::now();
+
+    REQUIRE( server.connect(client, now) );
+    const auto cookie = clients.receiveCookie();
+    REQUIRE( cookie );
+
+    GIVEN( "Cookie echoed back" ) {
+        REQUIRE( server.echo(client, cookie, now) );
+
+        THEN( "Connection attempt is let through to ENet" ) {
+            REQUIRE( !server.connect(client, now) );
+            const auto stats = server.admission.getStats();
+            REQUIRE( stats.challenged == 1 );
+            REQUIRE( stats.admitted == 1 );
+            REQUIRE( stats.rejected == 0 );
+        }
+
+        THEN( "Until the ticket expires" ) {
+            REQUIRE( !server.connect(client, now + 9s) );
+            REQUIRE( server.connect(client, now + 11s) );
+        }
+
+        THEN( "Other datagrams are not touched" ) {
+            REQUIRE( !server.deliver(client, {0x00, 0x01, 0x02, 0x03}, now) );
+        }
+    }
+
+    GIVEN( "Cookie echoed back late" ) {
+        THEN( "It is valid in the next time slot too" ) {
+            REQUIRE( server.echo(client, cookie, now + 5s) );
+            REQUIRE( server.admission.getStats().admitted == 1 );
+        }
+
+        THEN( "It is rejected after that" ) {
+            REQUIRE( server.echo(client, cookie, now + 11s) );
+            REQUIRE( server.admission.getStats().rejected == 1 );
+            REQUIRE( server.connect(client, now + 11s) );
+        }
+    }
+
+    GIVEN( "Forged cookies" ) {
+        THEN( "Wrong cookie is rejected" ) {
+            REQUIRE( server.echo(client, cookie ^ 1, now) );
+            REQUIRE( server.admission.getStats().rejected == 1 );
+            REQUIRE( server.connect(client, now) );
+        }
+
+        THEN( "Cookie of another address is rejected" ) {
+            const auto other = makeAddress(1);
+            REQUIRE( server.echo(other, cookie, now) );
+            REQUIRE( server.admission.getStats().rejected == 1 );
+            REQUIRE( server.connect(other, now) );
+            REQUIRE( server.connect(client, now) );
+        }
+    }
+
+    GIVEN( "Disabled admission" ) {
+        server.admission.setEnabled(false);
+
+        THEN( "Nothing is intercepted" ) {
+            REQUIRE( !server.connect(client, now) );
+            REQUIRE( !server.echo(client, cookie, now) );
+        }
+    }
+
+    GIVEN( "More admitted clients than the ticket table holds" ) {
+        constexpr auto count = 600u;
+        for (auto i = 1u; i <= count; ++i) {
+            const auto address = makeAddress(i);
+            server.connect(address, now);
+            server.echo(address, clients.receiveCookie(), now);
+        }
+        REQUIRE( server.admission.getStats().admitted == count );
+        REQUIRE( !server.connect(makeAddress(count), now) );
+
+        auto passed = 0u;
+        for (auto i = 1u; i <= count; ++i) {
+            passed += !server.connect(makeAddress(i), now);
+        }
+
+        THEN( "Older tickets are evicted and challenged again" ) {
+            REQUIRE( passed <= 256 );
+            REQUIRE( passed > 1 );
+            REQUIRE( server.connect(makeAddress(0), now) );
+        }
+    }
+}
+
+SCENARIO( "Raw host serviced directly", "[wenet][admission]" ) {
+    Host server{Address{port}, 1};
+    server.setAdmission(true);
+    Host client{};
+    client.connect({"localhost", port}, 1);
+
+    auto& raw = *static_cast<ENetHost*>(server);
+    ENetEvent event;
+    const auto deadline = Host::Clock::now() + 10s;
+    while (raw.peers[0].state != ENET_PEER_STATE_CONNECTED &&
+           Host::Clock::now() < deadline) {
+        while (enet_host_service(&raw, &event, 0) > 0) { }
+        client.service(1_ms);
+    }
+
+    THEN( "Datagrams are let through without admission" ) {
+        REQUIRE( raw.peers[0].state == ENET_PEER_STATE_CONNECTED );
+        REQUIRE( server.getAdmissionStats().challenged == 0 );
+    }
+}
+
+} // \wenet
+
+} // \sq
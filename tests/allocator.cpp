@@ -0,0 +1,85 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/allocator.hpp"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "ENet allocator", "[wenet][allocator]" ) {
+    GIVEN( "Blocks of every size class and some bigger ones" ) {
+        const auto before = Allocator::getStats();
+
+        std::vector<std::pair<byte*, size_t>> blocks;
+        for (auto size = size_t(1); size <= 4 * Allocator::MaxSmall;
+             size = size * 3 / 2 + 1) {
+            auto block = static_cast<byte*>(Allocator::allocate(size));
+            REQUIRE( block );
+            REQUIRE( reinterpret_cast<uintptr_t>(block) % 16 == 0 );
+            std::memset(block, int(size), size);
+            blocks.emplace_back(block, size);
+        }
+
+        THEN( "Blocks do not overlap and are counted as live" ) {
+            for (auto& block : blocks) {
+                for (auto i = size_t(0); i < block.second; ++i) {
+                    REQUIRE( block.first[i] == byte(block.second) );
+                }
+            }
+
+            auto total = size_t(0);
+            for (auto& block : blocks) total += block.second;
+            const auto stats = Allocator::getStats();
+            REQUIRE( stats.live - before.live == total );
+            REQUIRE( stats.peak >= stats.live );
+            REQUIRE( stats.reserved >= stats.live );
+            REQUIRE( stats.allocations - before.allocations == blocks.size() );
+        }
+
+        THEN( "Released blocks are not live and get reused" ) {
+            // in reverse, so the first block is the last one freed
+            for (auto i = blocks.size(); i--; ) {
+                Allocator::release(blocks[i].first);
+            }
+            Allocator::release(nullptr);
+
+            const auto stats = Allocator::getStats();
+            REQUIRE( stats.live == before.live );
+            REQUIRE( stats.frees - before.frees == blocks.size() );
+
+            auto block = Allocator::allocate(blocks.front().second);
+            REQUIRE( block == blocks.front().first );
+            Allocator::release(block);
+        }
+    }
+
+    GIVEN( "Blocks freed by another thread" ) {
+        const auto before = Allocator::getStats();
+
+        std::vector<void*> blocks(1000);
+        for (auto& block : blocks) block = Allocator::allocate(100);
+
+        std::thread{[&] {
+            for (auto block : blocks) Allocator::release(block);
+        }}.join();
+
+        THEN( "They are released and available to others" ) {
+            REQUIRE( Allocator::getStats().live == before.live );
+
+            // the exiting thread handed its blocks back to the pool
+            const auto reserved = Allocator::getStats().reserved;
+            for (auto& block : blocks) block = Allocator::allocate(100);
+            REQUIRE( Allocator::getStats().reserved == reserved );
+            for (auto block : blocks) Allocator::release(block);
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,60 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/packet.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "Shared buffer", "[wenet][buffer]" ) {
+    const byte data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    WHEN( "Packets are made from the buffer" ) {
+        SharedBuffer buffer{span<const byte>{data}};
+        {
+            Packet packet1{buffer};
+            Packet packet2{buffer.slice(2, 4), Packet::Flag::Unreliable};
+
+            THEN( "Every packet holds a reference" ) {
+                REQUIRE( buffer.getReferences() == 3 );
+            }
+            THEN( "Packets point into the buffer" ) {
+                REQUIRE( packet1.getData().data() == buffer.getData().data() );
+                REQUIRE( packet2.getData().data() == &buffer.getData()[2] );
+                REQUIRE( packet2.getSize() == 4 );
+                REQUIRE( packet2.getData()[0] == 3 );
+            }
+        }
+        THEN( "References are dropped with packets" ) {
+            REQUIRE( buffer.getReferences() == 1 );
+        }
+    }
+
+    WHEN( "Slice is out of range" ) {
+        SharedBuffer buffer{span<const byte>{data}};
+        THEN( "It throws" ) {
+            REQUIRE_THROWS_AS( buffer.slice(4, 5), SharedBuffer::Exception );
+        }
+    }
+
+    WHEN( "External memory is shared" ) {
+        byte memory[16];
+        auto released = false;
+        {
+            SharedBuffer buffer{memory, [](span<byte>, void* context) {
+                *static_cast<bool*>(context) = true;
+            }, &released};
+            Packet packet{buffer};
+            buffer = {};
+            REQUIRE( !released );
+        }
+        THEN( "It is released with the last reference" ) {
+            REQUIRE( released );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
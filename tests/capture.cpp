@@ -0,0 +1,81 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/capture.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "Traffic capture", "[wenet][capture]" ) {
+    using namespace std::chrono_literals;
+
+    const std::string path = "test_capture.wcap";
+    const ENetAddress first{1, 1000};
+    const ENetAddress second{2, 2000};
+    const std::vector<byte> small(10, 1);
+    const std::vector<byte> large(100, 2);
+
+    WHEN( "Datagrams are captured" ) {
+        {
+            Capture capture{path, 1024};
+            const auto now = Capture::Clock::now();
+            REQUIRE( capture.write(first, small, now + 1ms) );
+            REQUIRE( capture.write(second, large, now + 2ms) );
+        }
+
+        THEN( "They are read back in order" ) {
+            CaptureReader reader{path};
+            CaptureRecord record;
+
+            REQUIRE( reader.next(record) );
+            REQUIRE( record.address.host == first.host );
+            REQUIRE( record.address.port == first.port );
+            REQUIRE( record.time >= 1ms );
+            REQUIRE( record.data.size() == 10 );
+            REQUIRE( record.data[0] == 1 );
+
+            REQUIRE( reader.next(record) );
+            REQUIRE( record.address.port == second.port );
+            REQUIRE( record.time >= 2ms );
+            REQUIRE( record.data.size() == 100 );
+            REQUIRE( record.data[99] == 2 );
+
+            REQUIRE( !reader.next(record) );
+
+            reader.rewind();
+            REQUIRE( reader.next(record) );
+            REQUIRE( record.address.port == first.port );
+        }
+    }
+
+    WHEN( "Capture is full" ) {
+        Capture capture{path, 150};
+        const auto now = Capture::Clock::now();
+
+        THEN( "Datagrams that do not fit are dropped" ) {
+            REQUIRE( capture.write(first, large, now) );
+            REQUIRE( !capture.write(first, large, now) );
+            REQUIRE( capture.write(first, small, now) );
+            REQUIRE( capture.getDropped() == 1 );
+        }
+    }
+
+    WHEN( "File is not a capture" ) {
+        std::fclose(std::fopen(path.c_str(), "w"));
+
+        THEN( "It cannot be read" ) {
+            REQUIRE_THROWS_AS( CaptureReader{path}, Capture::Exception );
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+} // \wenet
+
+} // \sq
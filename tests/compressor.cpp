@@ -0,0 +1,298 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/compressor.hpp"
+#include "wenet/buffer.hpp"
+#include "wenet/packet.hpp"
+
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+std::vector<byte> makeMessage(int index)
+{
+    const auto text = "{\"type\":\"state\",\"player\":" +
+                      std::to_string(index) +
+                      ",\"position\":[12.5,40.25],\"inventory\":[\"sword\","
+                      "\"shield\",\"potion\",\"potion\"]}";
+    return {text.begin(), text.end()};
+}
+
+ENetPacket& makePacket(const std::vector<byte>& data, uint32_t flags)
+{
+    return *enet_packet_create(data.data(), data.size(), flags);
+}
+
+std::vector<byte> getData(const ENetPacket& packet)
+{
+    return {packet.data, packet.data + packet.dataLength};
+}
+
+} // \anonymous
+
+SCENARIO( "Stateful compression", "[wenet][compressor]" ) {
+    ENetPeer peers[2]{};
+    ENetHost host{};
+    host.peers = peers;
+    peers[0].host = peers[1].host = &host;
+
+    StatefulCompression sender{2};
+    StatefulCompression receiver{2};
+    sender.enable(1);
+    receiver.enable(1);
+
+    const auto reliable = ENET_PACKET_FLAG_RELIABLE;
+
+    GIVEN( "Repetitive reliable packets" ) {
+        std::vector<size_t> sizes;
+        for (auto i = 0; i < 20; ++i) {
+            const auto message = makeMessage(i);
+            auto& packet = makePacket(message, reliable);
+            auto compressed = sender.compress(peers[0], 1, packet);
+            REQUIRE( compressed );
+            sizes.push_back(compressed->dataLength);
+
+            auto result = receiver.decompress(peers[0], 1, *compressed);
+            REQUIRE( result );
+            REQUIRE( getData(*result) == message );
+
+            if (result != compressed) enet_packet_destroy(result);
+            enet_packet_destroy(compressed);
+            enet_packet_destroy(&packet);
+        }
+
+        THEN( "Later packets are compressed with the history" ) {
+            REQUIRE( sizes.back() * 3 < sizes.front() );
+            REQUIRE( sizes.back() * 3 < makeMessage(19).size() );
+        }
+    }
+
+    GIVEN( "Unreliable and small packets" ) {
+        const auto message = makeMessage(0);
+        const std::vector<byte> small(8, 1);
+
+        THEN( "They are sent as they are with a header" ) {
+            auto& packet = makePacket(message, 0);
+            auto compressed = sender.compress(peers[0], 1, packet);
+            REQUIRE( compressed->dataLength == message.size() + 1 );
+            auto result = receiver.decompress(peers[0], 1, *compressed);
+            REQUIRE( result == compressed );
+            REQUIRE( getData(*result) == message );
+            enet_packet_destroy(compressed);
+            enet_packet_destroy(&packet);
+
+            auto& other = makePacket(small, reliable);
+            compressed = sender.compress(peers[0], 1, other);
+            REQUIRE( compressed->dataLength == small.size() + 1 );
+            result = receiver.decompress(peers[0], 1, *compressed);
+            REQUIRE( getData(*result) == small );
+            enet_packet_destroy(compressed);
+            enet_packet_destroy(&other);
+        }
+    }
+
+    GIVEN( "Packets pointing to memory they do not own" ) {
+        const auto message = makeMessage(0);
+        const SharedBuffer buffer{message};
+        const auto unmanaged = Packet::Flags(Packet::Flag::Unmanaged);
+
+        THEN( "Copies of their data are sent" ) {
+            const auto unreliable = Packet::Flags(Packet::Flag::Unreliable);
+            for (auto flags : {unreliable, Packet::Flags(reliable)}) {
+                const Packet shared{buffer, flags};
+                const Packet user{message, flags | unmanaged};
+
+                // kept until both are compressed, nothing may be reused
+                auto first = sender.compress(peers[0], 1, *shared);
+                auto second = sender.compress(peers[0], 1, *user);
+                REQUIRE( first );
+                REQUIRE( second );
+                REQUIRE( !(first->flags & ENET_PACKET_FLAG_NO_ALLOCATE) );
+                REQUIRE( !(second->flags & ENET_PACKET_FLAG_NO_ALLOCATE) );
+
+                for (auto compressed : {first, second}) {
+                    auto result = receiver.decompress(peers[0], 1,
+                                                      *compressed);
+                    REQUIRE( result );
+                    REQUIRE( getData(*result) == message );
+                    if (result != compressed) enet_packet_destroy(result);
+                    enet_packet_destroy(compressed);
+                }
+            }
+        }
+    }
+
+    GIVEN( "Streams of different peers and after a reset" ) {
+        sender.enable(2);
+        receiver.enable(2);
+        const auto message = makeMessage(0);
+        auto& packet = makePacket(message, reliable);
+
+        auto first = sender.compress(peers[0], 2, packet);
+        auto second = sender.compress(peers[1], 2, packet);
+
+        THEN( "Peers do not share history" ) {
+            REQUIRE( getData(*first) == getData(*second) );
+        }
+
+        THEN( "Reset starts the history over" ) {
+            sender.reset(peers[0]);
+            auto again = sender.compress(peers[0], 2, packet);
+            REQUIRE( getData(*again) == getData(*first) );
+            enet_packet_destroy(again);
+        }
+
+        THEN( "Packet decompressed with the wrong history is rejected" ) {
+            auto result = receiver.decompress(peers[0], 2, *first);
+            REQUIRE( result );
+            enet_packet_destroy(result);
+            auto repeated = sender.compress(peers[1], 2, packet);
+            REQUIRE( !receiver.decompress(peers[1], 2, *repeated) );
+            enet_packet_destroy(repeated);
+        }
+
+        enet_packet_destroy(first);
+        enet_packet_destroy(second);
+        enet_packet_destroy(&packet);
+    }
+}
+
+SCENARIO( "Packet compression", "[wenet][compressor]" ) {
+    PacketCompression sender;
+    PacketCompression receiver;
+    sender.setCompressor(std::make_unique<compressor::Zlib>());
+    receiver.setCompressor(std::make_unique<compressor::Zlib>());
+    sender.enable(1);
+    receiver.enable(1);
+
+    auto message = makeMessage(0);
+    for (auto i = 1; i < 4; ++i) {
+        const auto more = makeMessage(i);
+        message.insert(message.end(), more.begin(), more.end());
+    }
+    const auto reliable = ENET_PACKET_FLAG_RELIABLE;
+
+    // receiver gets the packet ENet delivered back (a new one if it was
+    // compressed), both are released
+    const auto roundTrip = [&receiver](ENetPacket& packet) {
+        auto copy = &makePacket(getData(packet), packet.flags);
+        auto result = receiver.decompress(*copy);
+        auto data = result ? getData(*result) : std::vector<byte>{};
+        if (result && result != copy) enet_packet_destroy(result);
+        enet_packet_destroy(copy);
+        return data;
+    };
+
+    GIVEN( "Packet owning its data" ) {
+        auto& packet = makePacket(message, reliable);
+        sender.compress(1, packet);
+
+        THEN( "It is compressed in place and restored" ) {
+            REQUIRE( packet.dataLength < message.size() );
+            REQUIRE( roundTrip(packet) == message );
+        }
+
+        THEN( "Second broadcast of it leaves it as it is" ) {
+            const auto compressed = getData(packet);
+            sender.compress(1, packet);
+            REQUIRE( getData(packet) == compressed );
+            REQUIRE( roundTrip(packet) == message );
+        }
+
+        enet_packet_destroy(&packet);
+    }
+
+    GIVEN( "Packet pointing to user memory" ) {
+        auto freed = false;
+        auto& packet = makePacket(message,
+                                  reliable | ENET_PACKET_FLAG_NO_ALLOCATE);
+        packet.userData = &freed;
+        packet.freeCallback = [](ENetPacket* packet) {
+            *static_cast<bool*>(packet->userData) = true;
+        };
+        sender.compress(1, packet);
+
+        THEN( "It gets memory of its own and user memory is released" ) {
+            REQUIRE( freed );
+            REQUIRE( packet.data != message.data() );
+            REQUIRE( !(packet.flags & ENET_PACKET_FLAG_NO_ALLOCATE) );
+            REQUIRE( !packet.freeCallback );
+            REQUIRE( roundTrip(packet) == message );
+        }
+
+        enet_packet_destroy(&packet);
+    }
+
+    GIVEN( "Incompressible and small packets" ) {
+        std::vector<byte> noise(1000);
+        auto state = uint32_t(42);
+        for (auto& value : noise) value = byte((state = state * 1103515245u +
+                                                        12345u) >> 24);
+        const std::vector<byte> small(8, 1);
+
+        THEN( "They are sent raw behind a one byte header" ) {
+            for (auto data : {noise, small}) {
+                auto& packet = makePacket(data, reliable);
+                sender.compress(1, packet);
+                REQUIRE( packet.dataLength == data.size() + 1 );
+                REQUIRE( roundTrip(packet) == data );
+
+                sender.compress(1, packet);
+                REQUIRE( packet.dataLength == data.size() + 1 );
+                enet_packet_destroy(&packet);
+            }
+        }
+    }
+
+    GIVEN( "Channel without compression" ) {
+        auto& packet = makePacket(message, reliable);
+        sender.compress(2, packet);
+
+        THEN( "Packet is left alone" ) {
+            REQUIRE( getData(packet) == message );
+        }
+
+        enet_packet_destroy(&packet);
+    }
+
+    GIVEN( "Malformed packets" ) {
+        auto& packet = makePacket(message, reliable);
+        sender.compress(1, packet);
+        auto compressed = getData(packet);
+        enet_packet_destroy(&packet);
+
+        THEN( "They are rejected" ) {
+            auto corrupt = compressed;
+            for (auto i = 5u; i < corrupt.size(); ++i) corrupt[i] ^= 0x5A;
+            auto longer = compressed;
+            longer[4]++; // original size one more than inflated
+            auto huge = compressed;
+            huge[1] = 0xFF;
+            auto empty = compressed; // original size 0
+            std::fill(empty.begin() + 1, empty.begin() + 5, 0);
+            const std::vector<byte> header(compressed.begin(),
+                                           compressed.begin() + 5);
+
+            const std::vector<std::vector<byte>> malformed{
+                {}, {7, 1, 2, 3}, {1, 0, 0}, corrupt, longer, huge, empty,
+                header
+            };
+            for (auto& data : malformed) {
+                auto& bad = makePacket(data, reliable);
+                REQUIRE( !receiver.decompress(bad) );
+                enet_packet_destroy(&bad);
+            }
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,114 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <deque>
+#include <set>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+using Mode = CongestionControl::Mode;
+
+// Bottleneck with a queue in front of it and a fixed delay behind it. Data
+// handed over is in transit until it has been through both, unless it is
+// unreliable and so never acknowledged
+struct Path {
+    static constexpr auto Rate = 1000000.0; // bytes per second
+    static constexpr auto Delay = 20u; // ms
+
+    double queue = 0;
+    std::deque<double> pipe = std::deque<double>(Delay, 0.0);
+    double piped = 0;
+
+    void step(ENetPeer& peer, size_t sent, bool reliable)
+    {
+        queue += sent;
+        const auto served = std::min(queue, Rate / 1000);
+        queue -= served;
+
+        pipe.push_back(served);
+        piped += served - pipe.front();
+        pipe.pop_front();
+
+        peer.reliableDataInTransit = reliable ? uint32_t(queue + piped) : 0;
+        peer.roundTripTime = Delay + uint32_t(queue * 1000 / Rate);
+    }
+};
+
+SCENARIO( "Congestion control", "[wenet][congestion]" ) {
+    Host host{}; // for an initialised peer, nothing is sent through it
+    auto& peer = static_cast<ENetHost*>(host)->peers[0];
+    peer.mtu = 1000;
+    peer.roundTripTime = Path::Delay;
+
+    CongestionControl control{1};
+    Path path;
+    auto now = CongestionControl::Clock::now();
+
+    // application always has more to send than it is allowed to
+    std::set<Mode> modes;
+    auto queued = 0.0; // most queued at the bottleneck after the first second
+    const auto run = [&](size_t ms, bool reliable) {
+        for (auto i = 0u; i < ms; ++i) {
+            const auto sent = std::min<size_t>(control.update(peer, true, now),
+                                               64 * 1000);
+            control.onSent(peer, sent, reliable ? sent : 0);
+            path.step(peer, sent, reliable);
+
+            modes.insert(control.getMode(peer));
+            if (i >= 1000) queued = std::max(queued, path.queue);
+            now += std::chrono::milliseconds{1};
+        }
+    };
+
+    GIVEN( "Reliable data" ) {
+        run(3000, true);
+
+        THEN( "It starts up, drains the queue and cruises" ) {
+            REQUIRE( modes == std::set<Mode>({
+                Mode::Startup, Mode::Drain, Mode::ProbeBandwidth
+            }) );
+            REQUIRE( control.getMode(peer) == Mode::ProbeBandwidth );
+        }
+
+        THEN( "Bandwidth and round trip time of the path are found" ) {
+            REQUIRE( control.getBandwidth(peer) >= Path::Rate * 0.95 );
+            REQUIRE( control.getBandwidth(peer) <= Path::Rate * 1.05 );
+            REQUIRE( control.getMinRoundTripTime(peer) ==
+                     time::ms{Path::Delay} );
+        }
+
+        THEN( "Queue stays below half the bandwidth delay product" ) {
+            REQUIRE( queued < Path::Rate * Path::Delay / 1000 / 2 );
+        }
+
+        THEN( "Reset starts over" ) {
+            control.reset(peer);
+            REQUIRE( control.getMode(peer) == Mode::Startup );
+            REQUIRE( control.getBandwidth(peer) == 0 );
+        }
+    }
+
+    GIVEN( "Unreliable data only" ) {
+        run(3000, false);
+
+        THEN( "Nothing counts as delivered" ) {
+            REQUIRE( control.getBandwidth(peer) == 0 );
+        }
+
+        THEN( "Pacing stays at the initial estimate" ) {
+            // ten datagrams per round trip at the startup gain at most
+            const auto initial = 10 * peer.mtu * 1000 / Path::Delay;
+            REQUIRE( control.getPacingRate(peer) <= initial * 2.885 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/coroutine.hpp"
+
+#include <chrono>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto port = 1250u;
+
+struct Progress {
+    bool connected = false;
+    std::vector<byte> reply;
+    bool timedOut = false;
+    Clock::duration slept{};
+    bool sleeping = false;
+    bool disconnected = false;
+    bool finished = false;
+};
+
+coro::Flow session(coro::Scheduler& scheduler, Progress& progress)
+{
+    auto peer = co_await scheduler.connect({"localhost", port}, 2);
+    if (!peer) co_return;
+    progress.connected = true;
+
+    const std::vector<byte> hello{1, 2, 3};
+    auto reply = co_await scheduler.request(*peer, {hello}, 0, 5000_ms);
+    if (reply) {
+        const auto data = reply->getData();
+        progress.reply.assign(data.begin(), data.end());
+    }
+
+    // nothing is ever sent on channel 1
+    progress.timedOut = !co_await scheduler.receive(*peer, 1, 20_ms);
+
+    const auto start = Clock::now();
+    co_await scheduler.sleep(20_ms);
+    progress.slept = Clock::now() - start;
+
+    progress.sleeping = true;
+    progress.disconnected = !co_await scheduler.receive(*peer);
+    progress.finished = true;
+}
+
+SCENARIO( "Coroutine flow", "[wenet][coroutine]" ) {
+    Host server{Address{port}, 1};
+    server.onReceive([](Peer& peer, Packet&& packet, uint8_t channelId) {
+        peer.send(Packet{packet.getData()}, channelId);
+    });
+
+    Host client{};
+    coro::Scheduler scheduler{client};
+    auto unawaited = 0;
+    scheduler.onDisconnect([&unawaited](size_t, uint32_t) { ++unawaited; });
+
+    Progress progress;
+    session(scheduler, progress);
+    REQUIRE( scheduler.getPending() == 1 );
+
+    auto disconnecting = false;
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!progress.finished && Clock::now() < deadline) {
+        if (progress.sleeping && !disconnecting && server.getPeerCount()) {
+            server.getPeers()[0].disconnect();
+            disconnecting = true;
+        }
+        server.service();
+        scheduler.service(1_ms);
+    }
+
+    THEN( "Connect resumes with the peer" ) {
+        REQUIRE( progress.connected );
+    }
+
+    THEN( "Request resumes with the reply" ) {
+        REQUIRE( progress.reply == std::vector<byte>({1, 2, 3}) );
+    }
+
+    THEN( "Receive resumes empty once its timeout passes" ) {
+        REQUIRE( progress.timedOut );
+    }
+
+    THEN( "Sleep resumes after its duration" ) {
+        REQUIRE( progress.slept >= std::chrono::milliseconds{20} );
+    }
+
+    THEN( "Disconnect resumes the awaiting receive empty" ) {
+        REQUIRE( progress.disconnected );
+        REQUIRE( progress.finished );
+        REQUIRE( scheduler.getPending() == 0 );
+        REQUIRE( unawaited == 1 );
+    }
+}
+
+} // \wenet
+
+} // \sq
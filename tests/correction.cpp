@@ -0,0 +1,151 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/correction.hpp"
+
+#include <vector>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+std::vector<byte> makeData(size_t size)
+{
+    std::vector<byte> data(size);
+    for (auto i = size_t(0); i < size; ++i) data[i] = byte(i * 7 + i / 251);
+    return data;
+}
+
+std::vector<byte> getData(const ENetPacket& packet)
+{
+    return {packet.data, packet.data + packet.dataLength};
+}
+
+// Sends the shards whose index is not lost, returns the rebuilt packet
+std::vector<byte> transfer(ErrorCorrection& sender, ErrorCorrection& receiver,
+                           ENetPeer& peer, const std::vector<byte>& data,
+                           const std::vector<size_t>& lost)
+{
+    auto& packet = *enet_packet_create(data.data(), data.size(), 0);
+    const auto shards = sender.encode(peer, packet);
+    enet_packet_destroy(&packet);
+
+    std::vector<byte> result;
+    for (auto i = size_t(0); i < size_t(shards.size()); ++i) {
+        auto shard = shards[i];
+        const auto skip = std::find(lost.begin(), lost.end(), i) != lost.end();
+        auto rebuilt = skip ? nullptr : receiver.decode(peer, 1, *shard);
+        if (rebuilt) {
+            REQUIRE( result.empty() );
+            result = getData(*rebuilt);
+            if (rebuilt != shard) enet_packet_destroy(rebuilt);
+        }
+        enet_packet_destroy(shard);
+    }
+    return result;
+}
+
+} // \anonymous
+
+SCENARIO( "Error correction", "[wenet][correction]" ) {
+    ENetPeer peer{};
+    ENetHost host{};
+    host.peers = &peer;
+    peer.host = &host;
+    peer.mtu = 1400;
+
+    ErrorCorrection sender{1};
+    ErrorCorrection receiver{1};
+    sender.setSettings({4, 1000});
+
+    // 10 data shards in 3 stripes (0 3 6 9, 1 4 7, 2 5 8), parity 10 11 12
+    const auto data = makeData(9500);
+
+    GIVEN( "Large unreliable packet" ) {
+        THEN( "It arrives without losses" ) {
+            REQUIRE( transfer(sender, receiver, peer, data, {}) == data );
+            REQUIRE( receiver.getStats().recovered == 0 );
+        }
+
+        THEN( "One lost shard per stripe is rebuilt" ) {
+            const auto before = receiver.getStats().recovered;
+            REQUIRE( transfer(sender, receiver, peer, data, {0, 4, 8}) ==
+                     data );
+            REQUIRE( transfer(sender, receiver, peer, data, {9, 11}) ==
+                     data );
+            REQUIRE( receiver.getStats().recovered == before + 2 );
+        }
+
+        THEN( "Two lost shards of a stripe are not" ) {
+            REQUIRE( transfer(sender, receiver, peer, data, {0, 3}).empty() );
+        }
+    }
+
+    GIVEN( "Small and reliable packets" ) {
+        const auto small = makeData(100);
+        auto& packet = *enet_packet_create(data.data(), data.size(),
+                                           ENET_PACKET_FLAG_RELIABLE);
+
+        THEN( "They are sent whole with a header" ) {
+            REQUIRE( transfer(sender, receiver, peer, small, {}) == small );
+
+            const auto shards = sender.encode(peer, packet);
+            REQUIRE( shards.size() == 1 );
+            REQUIRE( shards[0]->dataLength == data.size() + 1 );
+            REQUIRE( receiver.decode(peer, 1, *shards[0]) == shards[0] );
+            REQUIRE( getData(*shards[0]) == data );
+            enet_packet_destroy(shards[0]);
+        }
+        enet_packet_destroy(&packet);
+    }
+
+    GIVEN( "Small shards" ) {
+        sender.setSettings({4, 10});
+
+        THEN( "255 shards are the most a packet is split into" ) {
+            // 204 data and 51 parity shards
+            const auto most = makeData(2040);
+            auto& packet = *enet_packet_create(most.data(), most.size(), 0);
+            const auto shards = sender.encode(peer, packet);
+            REQUIRE( shards.size() == 255 );
+            for (auto shard : shards) enet_packet_destroy(shard);
+            enet_packet_destroy(&packet);
+
+            REQUIRE( transfer(sender, receiver, peer, most, {254}) == most );
+        }
+
+        THEN( "Packets that need more are sent whole" ) {
+            // 205 data and 52 parity shards
+            const auto large = makeData(2050);
+            auto& packet = *enet_packet_create(large.data(), large.size(), 0);
+            const auto shards = sender.encode(peer, packet);
+            REQUIRE( shards.size() == 1 );
+            REQUIRE( shards[0]->dataLength == large.size() + 1 );
+            enet_packet_destroy(shards[0]);
+            enet_packet_destroy(&packet);
+
+            REQUIRE( transfer(sender, receiver, peer, large, {}) == large );
+        }
+    }
+
+    GIVEN( "Shards of many packets in flight" ) {
+        ErrorCorrection other{1};
+        for (auto i = 0; i < 8; ++i) {
+            transfer(sender, other, peer, data, {0, 3});
+        }
+
+        THEN( "The oldest incomplete ones are given up on" ) {
+            REQUIRE( other.getStats().incomplete == 4 );
+            for (auto i = 0; i < 8; ++i) {
+                REQUIRE( transfer(sender, other, peer, data, {}) == data );
+            }
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,84 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto port = 1248u;
+
+// Queues unreliable packets with a short ttl next to reliable ones without
+// sending anything, then flushes after the ttl has passed
+void testExpiry(bool scheduled)
+{
+    Host server{Address{port}, 1};
+    if (scheduled) server.setChannelPriority(1, {1, 1});
+
+    Host client{};
+    client.connect({"localhost", port}, 2);
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!server.getPeerCount() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( server.getPeerCount() );
+    auto& peer = server.getPeers()[0];
+
+    const std::vector<byte> data(100, 0xAA);
+    for (auto i = 0; i < 10; ++i) {
+        REQUIRE( peer.send({data, Packet::Flag::Unreliable}, 1, 1_ms) );
+        REQUIRE( peer.send({data, Packet::Flag::Reliable}, 0, 1_ms) );
+    }
+    Packet shared{data, Packet::Flag::Unreliable};
+    shared.setTtl(1_ms);
+    server.broadcast(std::move(shared), 1);
+    server.broadcast({data, Packet::Flag::Unreliable}, 1); // no deadline
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    server.flush();
+
+    THEN( "Expired unreliable packets are counted and not sent" ) {
+        REQUIRE( peer.getExpiredPackets(1) == 11 );
+        REQUIRE( peer.getExpiredPackets() == 11 );
+    }
+
+    THEN( "Reliable packets are never expired" ) {
+        REQUIRE( peer.getExpiredPackets(0) == 0 );
+    }
+
+    THEN( "Others arrive" ) {
+        auto reliable = 0, unreliable = 0;
+        client.onReceive([&](Peer&, Packet&&, uint8_t channelId) {
+            ++(channelId ? unreliable : reliable);
+        });
+        while (reliable < 10 && Clock::now() < deadline) {
+            server.service();
+            client.service(1_ms);
+        }
+        REQUIRE( reliable == 10 );
+        REQUIRE( unreliable <= 1 );
+    }
+}
+
+SCENARIO( "Packet expiry", "[wenet][expiry]" ) {
+    GIVEN( "Packets queued in ENet" ) {
+        testExpiry(false);
+    }
+
+    GIVEN( "Packets held by the channel scheduler" ) {
+        testExpiry(true);
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,170 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = Host::Clock;
+using namespace std::chrono_literals;
+
+constexpr auto port = 1257u;
+constexpr auto count = 3u;
+
+SCENARIO( "Fan-out", "[wenet][fanout]" ) {
+    Host server{Address{port}, count};
+
+    // connected one at a time, so server.getPeers()[i] is clients[i]
+    std::vector<std::unique_ptr<Host>> clients;
+    unsigned received[count] = {};
+    int payload[count] = {};
+    for (auto i = 0u; i < count; ++i) {
+        clients.push_back(std::make_unique<Host>());
+        auto& client = *clients.back();
+        client.connect({"localhost", port}, 1);
+        client.onReceive([&, i](Peer&, Packet&& packet, uint8_t) {
+            ++received[i];
+            payload[i] = packet.getData()[0];
+        });
+
+        const auto deadline = Clock::now() + 10s;
+        while (server.getPeerCount() == i && Clock::now() < deadline) {
+            server.service();
+            client.service(1_ms);
+        }
+        REQUIRE( server.getPeerCount() == i + 1 );
+    }
+    for (auto& client : clients) client->service();
+
+    auto peers = server.getPeers();
+    const std::vector<byte> data(16, 1);
+
+    auto deliver = [&] {
+        server.flush();
+        const auto deadline = Clock::now() + 100ms;
+        while (Clock::now() < deadline) {
+            server.service();
+            for (auto& client : clients) client->service(1_ms);
+        }
+    };
+
+    GIVEN( "Packet sent to some peers" ) {
+        const Peer* targets[] = {&peers[0], &peers[2]};
+        Packet packet{data};
+        const auto& shared = *static_cast<ENetPacket*>(packet);
+        const auto sent = server.sendTo(targets, std::move(packet));
+
+        THEN( "They share one packet" ) {
+            REQUIRE( sent == 2 );
+            REQUIRE( shared.referenceCount == 2 );
+        }
+
+        THEN( "Only they receive it" ) {
+            deliver();
+            REQUIRE( received[0] == 1 );
+            REQUIRE( received[1] == 0 );
+            REQUIRE( received[2] == 1 );
+        }
+    }
+
+    GIVEN( "Packet broadcast except to one peer" ) {
+        Packet packet{data};
+        const auto& shared = *static_cast<ENetPacket*>(packet);
+        const auto sent = server.broadcastExcept(peers[1], std::move(packet));
+
+        THEN( "The others share one packet" ) {
+            REQUIRE( sent == 2 );
+            REQUIRE( shared.referenceCount == 2 );
+        }
+
+        THEN( "It is excluded" ) {
+            deliver();
+            REQUIRE( received[0] == 1 );
+            REQUIRE( received[1] == 0 );
+            REQUIRE( received[2] == 1 );
+        }
+    }
+
+    GIVEN( "Packet broadcast by a predicate" ) {
+        Packet packet{data};
+        const auto& shared = *static_cast<ENetPacket*>(packet);
+        const auto sent = server.broadcastIf([&](const Peer& peer) {
+            return &peer == &peers[1];
+        }, std::move(packet));
+
+        THEN( "Only the peers it accepts get it" ) {
+            REQUIRE( sent == 1 );
+            REQUIRE( shared.referenceCount == 1 );
+            deliver();
+            REQUIRE( received[0] == 0 );
+            REQUIRE( received[1] == 1 );
+            REQUIRE( received[2] == 0 );
+        }
+    }
+
+    GIVEN( "Peer disconnected by the predicate" ) {
+        const auto disconnected = static_cast<ENetPeer*>(peers[0]);
+        auto visited = 0u;
+        const auto sent = server.broadcastIf([&](const Peer& peer) {
+            ++visited;
+            if (static_cast<ENetPeer*>(peer) == disconnected) {
+                peer.disconnectNow();
+                return false;
+            }
+            return true;
+        }, Packet{data});
+
+        THEN( "The rest are still visited once each" ) {
+            REQUIRE( server.getPeerCount() == count - 1 );
+            REQUIRE( visited == count );
+            REQUIRE( sent == count - 1 );
+            deliver();
+            REQUIRE( received[0] == 0 );
+            REQUIRE( received[1] == 1 );
+            REQUIRE( received[2] == 1 );
+        }
+    }
+
+    GIVEN( "Packet built for each peer" ) {
+        server.setWorkThreads(2);
+        const auto sent = server.sendEach([&](const Peer& peer) {
+            const std::vector<byte> own(8, byte(&peer - peers.data() + 1));
+            return Packet{own};
+        });
+
+        THEN( "Every peer gets exactly its own" ) {
+            REQUIRE( sent == count );
+            deliver();
+            for (auto i = 0u; i < count; ++i) {
+                REQUIRE( received[i] == 1 );
+                REQUIRE( payload[i] == int(i + 1) );
+            }
+        }
+    }
+
+    GIVEN( "Peer that is disconnecting" ) {
+        peers[2].disconnect();
+
+        THEN( "It is skipped by every fan-out" ) {
+            const Peer* targets[] = {&peers[0], &peers[2]};
+            REQUIRE( server.sendTo(targets, Packet{data}) == 1 );
+            REQUIRE( server.broadcastExcept(peers[1], Packet{data}) == 1 );
+            REQUIRE( server.broadcastIf([](const Peer&) { return true; },
+                                        Packet{data}) == 2 );
+            deliver();
+            REQUIRE( received[0] == 3 );
+            REQUIRE( received[1] == 1 );
+            REQUIRE( received[2] == 0 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
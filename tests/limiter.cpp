@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/limiter.hpp"
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "Rate limiter", "[wenet][limiter]" ) {
+    using namespace std::chrono_literals;
+
+    RateLimiter limiter{64};
+    const auto now = RateLimiter::Clock::now();
+    const ENetAddress first{1, 1000};
+    const ENetAddress second{1, 1001};
+    const ENetAddress other{2, 1000};
+
+    const auto count = [&](const ENetAddress& address, size_t bytes,
+                           RateLimiter::Clock::time_point time) {
+        auto passed = 0u;
+        for (auto i = 0; i < 100; ++i) {
+            if (!limiter.intercept(address, bytes, time)) passed++;
+        }
+        return passed;
+    };
+
+    WHEN( "Limit is not set" ) {
+        THEN( "Nothing is dropped" ) {
+            REQUIRE( !limiter.isEnabled() );
+            REQUIRE( count(first, 1000, now) == 100 );
+        }
+    }
+
+    WHEN( "Peer packet rate is limited" ) {
+        limiter.setLimit({{0, 0}, {10, 0}});
+        THEN( "New address gets a tenth of a second worth" ) {
+            REQUIRE( count(first, 100, now) == 1 );
+            REQUIRE( count(second, 100, now) == 1 );
+            REQUIRE( limiter.getStats().droppedPackets == 198 );
+            REQUIRE( limiter.getStats().droppedBytes == 19800 );
+        }
+        THEN( "Tokens are refilled over time" ) {
+            count(first, 100, now);
+            REQUIRE( count(first, 100, now + 500ms) == 5 );
+        }
+        THEN( "Up to a burst of one second is accumulated" ) {
+            count(first, 100, now);
+            REQUIRE( count(first, 100, now + 5s) == 10 );
+        }
+    }
+
+    WHEN( "Source byte rate is limited" ) {
+        limiter.setLimit({{0, 1000}, {0, 0}});
+        THEN( "All ports of an address share it" ) {
+            REQUIRE( count(first, 10, now) == 10 );
+            REQUIRE( count(second, 10, now) == 0 );
+            REQUIRE( count(other, 10, now) == 10 );
+        }
+        THEN( "First datagram of a new address is let through" ) {
+            REQUIRE( count(first, 500, now) == 1 );
+        }
+    }
+
+    WHEN( "Both rates are limited" ) {
+        limiter.setLimit({{10, 0}, {1, 0}});
+        limiter.intercept(first, 100, now);
+        count(first, 100, now + 1s); // one passes, the rest is dropped
+
+        THEN( "Datagrams dropped for the address do not use up the source" ) {
+            REQUIRE( count(second, 100, now + 1s) == 1 );
+            REQUIRE( limiter.getStats().droppedPackets == 99 + 99 );
+        }
+
+        THEN( "Rotating ports does not get around the source limit" ) {
+            auto passed = 0u;
+            for (auto port = 2000u; port < 3000u; ++port) {
+                passed += !limiter.intercept({1, uint16_t(port)}, 100,
+                                             now + 1s);
+            }
+            REQUIRE( passed == 9 );
+        }
+    }
+
+    WHEN( "More sources are seen than the table holds" ) {
+        limiter.setLimit({{0, 0}, {10, 0}});
+        count(first, 100, now + 5s);
+        for (auto i = 0u; i < 1000; ++i) limiter.intercept({i, 1}, 1, now);
+        THEN( "Table does not grow, evicted buckets start low again" ) {
+            REQUIRE( count(first, 100, now + 5s) <= 1 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,123 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/message.hpp"
+
+#include <array>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+struct Move {
+    uint16_t id;
+    float x;
+    float y;
+    int8_t turn;
+    bool jumping;
+    message::Optional<uint32_t> target;
+};
+
+using namespace message;
+
+using MoveSchema = Schema<Move,
+    WENET_FIELD(&Move::id, Int<0, 1023>),
+    WENET_FIELD(&Move::x, Float<-512, 512, 16>),
+    WENET_FIELD(&Move::y, Float<-512, 512, 16>),
+    WENET_FIELD(&Move::turn, Int<-3, 3>),
+    WENET_FIELD(&Move::jumping, Bool),
+    WENET_FIELD(&Move::target, Opt<Int<0, 99999>>)
+>;
+
+} // \anonymous
+
+SCENARIO( "Bit-packed messages", "[wenet][message]" ) {
+    std::array<byte, MoveSchema::MaxSize> data{};
+
+    GIVEN( "Schema" ) {
+        THEN( "Fields take only the bits their ranges need" ) {
+            REQUIRE( MoveSchema::MaxBits == 10 + 16 + 16 + 3 + 1 + 1 + 17 );
+            REQUIRE( MoveSchema::MaxSize == 8 );
+        }
+    }
+
+    WHEN( "Message is written and read back" ) {
+        const Move move{1000, 100.25f, -3.5f, -2, true, 12345u};
+        REQUIRE( MoveSchema::write(move, data) == 8 );
+
+        Move result{};
+        REQUIRE( MoveSchema::read(data, result) );
+
+        THEN( "Integers are exact and floats are within the quantum" ) {
+            REQUIRE( result.id == 1000 );
+            REQUIRE( std::abs(result.x - move.x) <= 1024.f / 65535 );
+            REQUIRE( std::abs(result.y - move.y) <= 1024.f / 65535 );
+            REQUIRE( result.turn == -2 );
+            REQUIRE( result.jumping );
+            REQUIRE( result.target );
+            REQUIRE( *result.target == 12345u );
+        }
+    }
+
+    WHEN( "Optional field is not set" ) {
+        const Move move{1, 0, 0, 0, false, {}};
+
+        THEN( "Only its presence bit is written" ) {
+            REQUIRE( MoveSchema::getSize(move) == 6 );
+            REQUIRE( MoveSchema::write(move, data) == 6 );
+
+            Move result{};
+            result.target = 5u;
+            REQUIRE( MoveSchema::read({data.data(), 6}, result) );
+            REQUIRE( !result.target );
+        }
+    }
+
+    WHEN( "Values are out of range" ) {
+        const Move move{2000, 1000.f, -1000.f, 10, false, {}};
+        MoveSchema::write(move, data);
+
+        Move result{};
+        MoveSchema::read(data, result);
+
+        THEN( "They are clamped" ) {
+            REQUIRE( result.id == 1023 );
+            REQUIRE( result.x == 512.f );
+            REQUIRE( result.y == -512.f );
+            REQUIRE( result.turn == 3 );
+        }
+    }
+
+    WHEN( "Data is truncated" ) {
+        const Move move{1, 0, 0, 0, false, 7u};
+        MoveSchema::write(move, data);
+
+        Move result{};
+        THEN( "Message cannot be read" ) {
+            REQUIRE( !MoveSchema::read({data.data(), 4}, result) );
+        }
+    }
+
+    WHEN( "Data holds an integer outside the range" ) {
+        data.fill(byte(0xff));
+
+        Move result{};
+        THEN( "Message cannot be read" ) {
+            REQUIRE( !MoveSchema::read(data, result) );
+        }
+    }
+
+    WHEN( "Buffer is too small" ) {
+        const Move move{1, 0, 0, 0, false, {}};
+        THEN( "Writing throws" ) {
+            REQUIRE_THROWS_AS( MoveSchema::write(move, {data.data(), 5}),
+                               message::Exception );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+constexpr auto port = 1259u;
+
+SCENARIO( "Send pacing", "[wenet][pacer]" ) {
+    ENetPeer peers[2]{};
+    ENetHost host{};
+    host.peers = peers;
+    peers[0].host = peers[1].host = &host;
+    peers[0].mtu = peers[1].mtu = 1000;
+
+    using namespace std::chrono;
+    const auto start = Pacer::Clock::now();
+    Pacer pacer{2};
+
+    GIVEN( "No rates" ) {
+        THEN( "Pacing is off" ) {
+            REQUIRE( !pacer.isEnabled() );
+        }
+    }
+
+    GIVEN( "Rate per peer" ) {
+        // 1 MB/s, a full bucket lasts 4 ms
+        pacer.setSettings({1000000, 0, time::us{4000}});
+
+        THEN( "Bucket starts full and refills at the rate" ) {
+            REQUIRE( pacer.isEnabled() );
+            REQUIRE( pacer.update(peers[0], start) == 4000 );
+            pacer.onSent(peers[0], 4500, start); // last packet overshoots
+            REQUIRE( pacer.update(peers[0], start) == 0 );
+            REQUIRE( pacer.update(peers[0], start + 1500us) == 1000 );
+            REQUIRE( pacer.update(peers[0], start + 1s) == 4000 );
+            REQUIRE( pacer.update(peers[1], start + 1s) == 4000 );
+        }
+
+        THEN( "Gaps between hand overs are measured" ) {
+            pacer.update(peers[1], start);
+            pacer.onSent(peers[1], 1000, start);
+            pacer.onSent(peers[1], 1000, start + 2ms);
+            REQUIRE( pacer.getGaps(peers[1]).last == time::us{2000} );
+            pacer.onSent(peers[1], 1000, start + 3ms);
+            REQUIRE( pacer.getGaps(peers[1]).last == time::us{1000} );
+            REQUIRE( pacer.getGaps(peers[1]).average > time::us{1000} );
+            REQUIRE( pacer.getGaps(peers[1]).average < time::us{2000} );
+            REQUIRE( pacer.getGaps().last == time::us{1000} );
+        }
+    }
+
+    GIVEN( "Rate for the whole host" ) {
+        pacer.setSettings({0, 1000000, time::us{4000}});
+        pacer.reset(peers[0]);
+        pacer.reset(peers[1]);
+
+        THEN( "Peers share it" ) {
+            const auto later = start + 1min;
+            REQUIRE( pacer.update(peers[0], later) == 4000 );
+            pacer.onSent(peers[0], 3000, later);
+            REQUIRE( pacer.update(peers[1], later) == 1000 );
+        }
+    }
+}
+
+SCENARIO( "Host rate shared by backlogged peers", "[wenet][pacer]" ) {
+    using namespace std::chrono_literals;
+    using Clock = Host::Clock;
+    constexpr auto count = 4u;
+
+    Host server{Address{port}, count};
+    server.setPacing({0, 200000, time::us{4000}}); // 400 packets a second
+
+    std::vector<std::unique_ptr<Host>> clients;
+    std::vector<size_t> received(count);
+    for (auto i = 0u; i < count; ++i) {
+        clients.push_back(std::make_unique<Host>());
+        auto& client = *clients.back();
+        client.connect({"localhost", port}, 1);
+        client.onReceive([&received, i](Peer&, Packet&&, uint8_t) {
+            ++received[i];
+        });
+
+        const auto deadline = Clock::now() + 10s;
+        while (server.getPeerCount() == i && Clock::now() < deadline) {
+            server.service();
+            client.service(1_ms);
+        }
+        REQUIRE( server.getPeerCount() == i + 1 );
+    }
+
+    GIVEN( "More queued for every peer than the rate lets out" ) {
+        const std::vector<byte> data(500);
+        for (auto& peer : server.getPeers()) {
+            for (auto i = 0; i < 1000; ++i) {
+                peer.send({data, Packet::Flag::Unreliable});
+            }
+        }
+
+        const auto end = Clock::now() + 1s;
+        while (Clock::now() < end) {
+            server.service(1_ms);
+            for (auto& client : clients) client->service();
+        }
+
+        THEN( "Every peer gets a fair share" ) {
+            const auto least = *std::min_element(received.begin(),
+                                                 received.end());
+            const auto most = *std::max_element(received.begin(),
+                                                received.end());
+            INFO( "Packets per peer from " << least << " to " << most );
+            REQUIRE( least > 20 );
+            REQUIRE( least * 3 > most * 2 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,113 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = Host::Clock;
+using namespace std::chrono_literals;
+
+constexpr auto port = 1256u;
+
+SCENARIO( "Polling settings", "[wenet][poll]" ) {
+    Host host{};
+
+    GIVEN( "Spinning without busy polling" ) {
+        REQUIRE( host.setPolling({200_us, false}) );
+
+        THEN( "Settings are kept and nothing is learned yet" ) {
+            REQUIRE( host.getPolling().spin == 200_us );
+            REQUIRE( !host.getPolling().busyPoll );
+            REQUIRE( host.getSpinWindow() == 0_us );
+        }
+    }
+
+    GIVEN( "Busy polling" ) {
+        const auto enabled = host.setPolling({200_us, true});
+
+        THEN( "Settings tell whether the socket took it" ) {
+            REQUIRE( host.getPolling().busyPoll == enabled );
+            REQUIRE( host.getPolling().spin == 200_us );
+        }
+    }
+}
+
+SCENARIO( "Poll", "[wenet][poll]" ) {
+    Host server{Address{port}, 1};
+    server.setPolling({5000_us, false});
+    Host client{};
+    client.connect({"localhost", port}, 1);
+
+    auto connected = false;
+    client.onConnect([&connected](Peer&, uint32_t) { connected = true; });
+
+    auto deadline = Clock::now() + 10s;
+    while ((!connected || !server.getPeerCount()) && Clock::now() < deadline) {
+        server.poll(1_ms);
+        client.service(1_ms);
+    }
+    REQUIRE( connected );
+
+    auto received = 0u;
+    server.onReceive([&received](Peer&, Packet&&, uint8_t) { ++received; });
+
+    GIVEN( "Nothing arriving" ) {
+        const auto start = Clock::now();
+        const auto result = server.poll(5_ms);
+        const auto elapsed = Clock::now() - start;
+
+        THEN( "It blocks for the timeout and returns false" ) {
+            REQUIRE( !result );
+            REQUIRE( elapsed >= 4ms );
+            REQUIRE( elapsed < 100ms );
+        }
+    }
+
+    GIVEN( "Packets arriving a millisecond apart" ) {
+        const std::vector<byte> data(16, 1);
+        auto& peer = client.getPeers()[0];
+        for (auto i = 0; i < 100; ++i) {
+            peer.send({data});
+            client.flush();
+            deadline = Clock::now() + 1s;
+            while (received == unsigned(i) && Clock::now() < deadline) {
+                server.poll(1_ms);
+            }
+            client.service();
+            std::this_thread::sleep_for(1ms);
+        }
+
+        THEN( "Every one is delivered" ) {
+            REQUIRE( received == 100 );
+        }
+
+        THEN( "Spin window follows them within the limit" ) {
+            REQUIRE( server.getSpinWindow() > 0_us );
+            REQUIRE( server.getSpinWindow() <= 5000_us );
+        }
+
+        THEN( "Without spinning poll is still served" ) {
+            server.setPolling({0_us, false});
+            REQUIRE( server.getSpinWindow() == 0_us );
+
+            peer.send({data});
+            client.flush();
+            deadline = Clock::now() + 1s;
+            while (received == 100 && Clock::now() < deadline) {
+                server.poll(1_ms);
+            }
+            REQUIRE( received == 101 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,59 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/pool.hpp"
+
+#include <vector>
+#include <atomic>
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "Work pool", "[wenet][pool]" ) {
+    const auto visit = [](WorkPool& pool, size_t count) {
+        std::vector<std::atomic<int>> calls(count);
+        pool.run(count, [&](size_t index) {
+            calls[index]++;
+            // uneven work, so that slices get stolen
+            if (index % 13 == 0) std::this_thread::yield();
+        });
+
+        for (auto& call : calls) if (call != 1) return false;
+        return true;
+    };
+
+    WHEN( "Range is run" ) {
+        THEN( "Every index is visited exactly once" ) {
+            for (auto threads : {0u, 1u, 3u}) {
+                WorkPool pool{threads};
+                REQUIRE( pool.getThreadCount() == threads );
+                for (auto count : {0u, 1u, 7u, 1000u}) {
+                    REQUIRE( visit(pool, count) );
+                }
+            }
+        }
+    }
+
+    WHEN( "Task throws" ) {
+        WorkPool pool{3};
+        std::atomic<size_t> calls{0};
+
+        REQUIRE_THROWS_AS( pool.run(100, [&](size_t index) {
+            calls++;
+            if (index == 50) throw std::runtime_error{"Task"};
+        }), std::runtime_error );
+
+        THEN( "Exception reaches the caller after the whole run" ) {
+            REQUIRE( calls == 100 );
+        }
+
+        THEN( "Pool can be used again" ) {
+            REQUIRE( visit(pool, 100) );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
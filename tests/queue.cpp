@@ -0,0 +1,162 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto port = 1251u;
+
+// Watermarks fit four of the packets, nothing is sent until service()
+constexpr auto packetSize = 1000u;
+constexpr auto high = 4 * packetSize;
+constexpr auto low = packetSize;
+
+Peer& connect(Host& server, Host& client)
+{
+    client.connect({"localhost", port}, 1);
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!server.getPeerCount() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( server.getPeerCount() == 1 );
+    return server.getPeers()[0];
+}
+
+SCENARIO( "Watermarks", "[wenet][queue]" ) {
+    Host server{Address{port}, 1};
+    Host client{};
+
+    std::vector<size_t> highs, lows;
+    server.onHighWatermark([&highs](Peer&, size_t queued) {
+        highs.push_back(queued);
+    });
+    server.onLowWatermark([&lows](Peer&, size_t queued) {
+        lows.push_back(queued);
+    });
+
+    const std::vector<byte> data(packetSize, 0xAA);
+    const auto unreliable = [&data] {
+        return Packet{data, Packet::Flag::Unreliable};
+    };
+
+    GIVEN( "No limit" ) {
+        auto& peer = connect(server, client);
+        for (auto i = 0; i < 10; ++i) REQUIRE( peer.send(unreliable()) );
+
+        THEN( "Everything is queued and no callback is invoked" ) {
+            REQUIRE( peer.getQueue().packets == 10 );
+            REQUIRE( highs.empty() );
+        }
+    }
+
+    GIVEN( "Notify" ) {
+        server.setQueueLimit({high, low}, Host::Overflow::Notify);
+        auto& peer = connect(server, client);
+        for (auto i = 0; i < 10; ++i) REQUIRE( peer.send(unreliable()) );
+
+        THEN( "Packets are queued and high watermark is reported once" ) {
+            REQUIRE( peer.getQueue().packets == 10 );
+            REQUIRE( peer.getDroppedPackets() == 0 );
+            REQUIRE( highs == std::vector<size_t>{high} );
+        }
+
+        THEN( "Low watermark is reported once the queue drains" ) {
+            const auto deadline = Clock::now() + std::chrono::seconds{10};
+            while (lows.empty() && Clock::now() < deadline) {
+                server.service();
+                client.service(1_ms);
+            }
+            REQUIRE( lows.size() == 1 );
+            REQUIRE( lows[0] <= low );
+            REQUIRE( highs.size() == 1 );
+        }
+    }
+
+    GIVEN( "Notify and a backlog that expires" ) {
+        server.setQueueLimit({high, low}, Host::Overflow::Notify);
+        auto& peer = connect(server, client);
+        for (auto i = 0; i < 5; ++i) {
+            REQUIRE( peer.send(unreliable(), 0, 1_ms) );
+        }
+        REQUIRE( highs.size() == 1 );
+
+        THEN( "Low watermark is reported once it is gone" ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            server.flush();
+            REQUIRE( peer.getExpiredPackets() == 5 );
+            REQUIRE( lows == std::vector<size_t>{0} );
+        }
+    }
+
+    GIVEN( "DropOldest" ) {
+        server.setQueueLimit({high, low}, Host::Overflow::DropOldest);
+        auto& peer = connect(server, client);
+
+        THEN( "Oldest unreliable packets make room for new ones" ) {
+            for (auto i = 0; i < 10; ++i) REQUIRE( peer.send(unreliable()) );
+            REQUIRE( peer.getQueue().packets == 4 );
+            REQUIRE( peer.getQueue().bytes == high );
+            REQUIRE( peer.getDroppedPackets() == 6 );
+        }
+
+        THEN( "Reliable packets are kept, unreliable one is not queued" ) {
+            for (auto i = 0; i < 4; ++i) REQUIRE( peer.send({data}) );
+            REQUIRE( !peer.send(unreliable()) );
+            REQUIRE( peer.send({data}) );
+            REQUIRE( peer.getQueue().packets == 5 );
+            REQUIRE( peer.getDroppedPackets() == 1 );
+        }
+    }
+
+    GIVEN( "Reject" ) {
+        server.setQueueLimit({high, low}, Host::Overflow::Reject);
+        auto& peer = connect(server, client);
+
+        THEN( "Packets above the high watermark are not queued" ) {
+            for (auto i = 0; i < 4; ++i) REQUIRE( peer.send(unreliable()) );
+            for (auto i = 0; i < 6; ++i) REQUIRE( !peer.send({data}) );
+            REQUIRE( peer.getQueue().packets == 4 );
+            REQUIRE( peer.getDroppedPackets() == 6 );
+            REQUIRE( highs.size() == 1 );
+        }
+    }
+
+    GIVEN( "Disconnect" ) {
+        server.setQueueLimit({high, low}, Host::Overflow::Disconnect);
+        auto& peer = connect(server, client);
+        for (auto i = 0; i < 4; ++i) REQUIRE( peer.send(unreliable()) );
+
+        THEN( "Peer is disconnected but stays until service() is over" ) {
+            REQUIRE( !peer.send(unreliable()) );
+            REQUIRE( peer.getState() == Peer::State::Disconnected );
+            REQUIRE( !peer.send(unreliable()) );
+            REQUIRE( server.getPeerCount() == 1 );
+
+            server.service();
+            REQUIRE( server.getPeerCount() == 0 );
+        }
+
+        THEN( "Broadcast over the peers in the meantime is safe" ) {
+            REQUIRE( server.broadcastIf([](const Peer&) { return true; },
+                                        unreliable()) == 0 );
+            REQUIRE( server.getPeerCount() == 1 );
+            server.service();
+            REQUIRE( server.getPeerCount() == 0 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/router.hpp"
+#include "wenet/host.hpp"
+
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+namespace {
+
+std::vector<int> calls;
+
+void onMove(Peer&, Packet&& packet) { calls.push_back(packet.getData()[1]); }
+void onChat(Peer&, Packet&&) { calls.push_back(-1); }
+
+using Routes = StaticRouter<
+    Route<0, 1, onMove>,
+    Route<2, 7, onChat>
+>;
+
+struct Counter {
+    int count = 0;
+    void operator () (Peer&, Packet&&) { ++count; }
+};
+
+} // \anonymous
+
+SCENARIO( "Message routing", "[wenet][router]" ) {
+    Host host;
+    Peer peer{host};
+
+    byte move[] = {1, 42};
+    byte chat[] = {7, 0};
+    ENetPacket movePacket{};
+    movePacket.data = move;
+    movePacket.dataLength = sizeof(move);
+    ENetPacket chatPacket{};
+    chatPacket.data = chat;
+    chatPacket.dataLength = sizeof(chat);
+    ENetPacket emptyPacket{};
+
+    calls.clear();
+
+    GIVEN( "Runtime router" ) {
+        Router router;
+        Counter counter;
+        router.add(0, 1, counter);
+        router.add(2, 7, [](void* context, Peer&, Packet&&) {
+            *static_cast<int*>(context) = 7;
+        }, &counter.count);
+
+        THEN( "Packets go to the handler of their channel and id" ) {
+            Packet packet{movePacket, false};
+            REQUIRE( router.dispatch(peer, packet, 0) );
+            REQUIRE( counter.count == 1 );
+
+            Packet other{chatPacket, false};
+            REQUIRE( router.dispatch(peer, other, 2) );
+            REQUIRE( counter.count == 7 );
+        }
+
+        THEN( "Packets without a route are left alone" ) {
+            Packet packet{movePacket, false};
+            REQUIRE( !router.dispatch(peer, packet, 1) );
+            REQUIRE( !router.dispatch(peer, packet, 2) );
+            REQUIRE( packet.isInit() );
+
+            Packet empty{emptyPacket, false};
+            REQUIRE( !router.dispatch(peer, empty, 0) );
+            REQUIRE( counter.count == 0 );
+        }
+
+        THEN( "Removed routes are not used" ) {
+            router.remove(0, 1);
+            Packet packet{movePacket, false};
+            REQUIRE( !router.dispatch(peer, packet, 0) );
+        }
+    }
+
+    GIVEN( "Static router" ) {
+        THEN( "Packets go to the handler of their channel and id" ) {
+            Packet packet{movePacket, false};
+            REQUIRE( Routes::dispatch(peer, packet, 0) );
+            Packet other{chatPacket, false};
+            REQUIRE( Routes::dispatch(peer, other, 2) );
+            REQUIRE( calls == (std::vector<int>{42, -1}) );
+        }
+
+        THEN( "Packets without a route are left alone" ) {
+            Packet packet{movePacket, false};
+            REQUIRE( !Routes::dispatch(peer, packet, 2) );
+            REQUIRE( !Routes::dispatch(peer, packet, 200) );
+            REQUIRE( calls.empty() );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
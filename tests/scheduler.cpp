@@ -0,0 +1,301 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto port = 1240u;
+
+// Median latency of small channel 0 packets sent while channel 2 is busy
+// with a bulk transfer which takes longer than the whole measurement
+double measureLatency(bool prioritise)
+{
+    Host server{Address{port}, 1};
+    server.setBandwidth({0, 256 * 1024});
+    if (prioritise) {
+        server.setChannelPriority(0, {1, 1});
+        server.setChannelPriority(2, {0, 1});
+    }
+
+    Host client{};
+    client.connect({"localhost", port}, 3);
+
+    bool connected = false;
+    client.onConnect([&connected](Peer&, uint32_t) { connected = true; });
+
+    std::vector<double> latencies;
+    client.onReceive([&latencies](Peer&, Packet&& packet, uint8_t channelId) {
+        if (channelId) return;
+
+        Clock::rep sent;
+        std::memcpy(&sent, &packet.getData()[0], sizeof(sent));
+        const auto diff = Clock::now() - Clock::time_point{Clock::duration{sent}};
+        latencies.push_back(
+            std::chrono::duration<double, std::milli>(diff).count());
+    });
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while ((!connected || !server.getPeerCount()) && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( connected );
+    auto peer = server.getPeers()[0];
+
+    const std::vector<byte> chunk(4096, 0xAA);
+    for (auto i = 0; i < 2048; ++i) peer.send({chunk}, 2);
+
+    constexpr auto probes = 40u;
+    auto sent = 0u;
+    auto next = Clock::now();
+    while (latencies.size() < probes && Clock::now() < deadline) {
+        if (sent < probes && Clock::now() >= next) {
+            const auto now = Clock::now().time_since_epoch().count();
+            Packet packet{sizeof(now)};
+            std::memcpy(&packet.getData()[0], &now, sizeof(now));
+            peer.send(std::move(packet), 0);
+            next += std::chrono::milliseconds{5};
+            sent++;
+        }
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( latencies.size() == probes );
+
+    std::nth_element(latencies.begin(), latencies.begin() + probes / 2,
+                     latencies.end());
+    return latencies[probes / 2];
+}
+
+SCENARIO( "Specification Testing", "[wenet][scheduler][specs]" ) {
+    Host host{};
+
+    WHEN( "No priority is set" ) {
+        THEN( "Channels share the lowest level equally" ) {
+            REQUIRE( host.getChannelPriority(3).level == 0 );
+            REQUIRE( host.getChannelPriority(3).weight == 1 );
+        }
+    }
+    WHEN( "Priority is set" ) {
+        host.setChannelPriority(3, {2, 0});
+        THEN( "Level is kept and weight is at least one" ) {
+            REQUIRE( host.getChannelPriority(3).level == 2 );
+            REQUIRE( host.getChannelPriority(3).weight == 1 );
+        }
+    }
+}
+
+// Packets the test holds a reference to as well, so the scheduler's own
+// references can be counted, released at the end
+class Packets {
+public:
+    Packets() = default;
+    Packets(const Packets&) = delete;
+
+    ~Packets()
+    {
+        for (auto packet : held_) {
+            if (!--packet->referenceCount) enet_packet_destroy(packet);
+        }
+    }
+
+    ENetPacket& create(size_t size)
+    {
+        held_.push_back(enet_packet_create(nullptr, size, 0));
+        held_.back()->referenceCount++;
+        return *held_.back();
+    }
+
+private:
+    std::vector<ENetPacket*> held_;
+};
+
+SCENARIO( "State channel", "[wenet][scheduler][state]" ) {
+    Host owner{};
+    auto& peer = static_cast<ENetHost*>(owner)->peers[0];
+    peer.channelCount = 2; // not connected, ENet refuses what is drained
+
+    Packets packets;
+    ChannelScheduler scheduler{1};
+    scheduler.setKeyed(1, true);
+
+    GIVEN( "Many updates of a few keys" ) {
+        std::vector<ENetPacket*> all;
+        for (auto i = 0u; i < 30; ++i) {
+            auto& packet = packets.create(10 + i);
+            scheduler.push(peer, 1, packet, i % 3);
+            all.push_back(&packet);
+        }
+        auto& unkeyed = packets.create(5);
+        scheduler.push(peer, 0, unkeyed, 0);
+        scheduler.push(peer, 0, unkeyed, 0);
+
+        THEN( "Only the latest packet of every key is queued" ) {
+            const auto count = scheduler.count(peer, 1);
+            REQUIRE( count.packets == 3 );
+            REQUIRE( count.bytes == 37 + 38 + 39 );
+            for (auto i = 0u; i < 30; ++i) {
+                REQUIRE( all[i]->referenceCount == (i < 27 ? 1 : 2) );
+            }
+        }
+
+        THEN( "Channels that are not keyed queue every packet" ) {
+            REQUIRE( scheduler.count(peer, 0).packets == 2 );
+            REQUIRE( unkeyed.referenceCount == 3 );
+        }
+
+        THEN( "Key of a packet sent already is queued again" ) {
+            // keys stay known after the drain, their packets are gone
+            scheduler.drain(peer);
+            REQUIRE( scheduler.count(peer).packets == 0 );
+            REQUIRE( unkeyed.referenceCount == 1 );
+
+            auto& first = packets.create(1);
+            auto& second = packets.create(2);
+            REQUIRE( !scheduler.push(peer, 1, first, 0) );
+            REQUIRE( !scheduler.push(peer, 1, second, 1) );
+            REQUIRE( scheduler.count(peer, 1).packets == 2 );
+            REQUIRE( first.referenceCount == 2 );
+        }
+    }
+}
+
+SCENARIO( "Packets ENet refuses", "[wenet][scheduler]" ) {
+    Host owner{};
+    auto& peer = static_cast<ENetHost*>(owner)->peers[0];
+    peer.channelCount = 1; // not connected, ENet refuses everything
+
+    Packets packets;
+    ChannelScheduler scheduler{1};
+    auto& packet = packets.create(100);
+    scheduler.push(peer, 0, packet);
+    scheduler.push(peer, 0, packets.create(200));
+
+    THEN( "They are released and not counted as sent" ) {
+        size_t reliable, refused;
+        REQUIRE( scheduler.drain(peer, size_t(-1), reliable, refused) == 0 );
+        REQUIRE( reliable == 0 );
+        REQUIRE( refused == 2 );
+        REQUIRE( scheduler.count(peer).packets == 0 );
+        REQUIRE( packet.referenceCount == 1 );
+    }
+}
+
+SCENARIO( "State channel of a host", "[wenet][scheduler][state]" ) {
+    Host server{Address{port}, 1};
+    server.enableStateChannel(1);
+    Host client{};
+    client.connect({"localhost", port}, 2);
+
+    auto connected = false;
+    client.onConnect([&connected](Peer&, uint32_t) { connected = true; });
+    std::vector<byte> received;
+    client.onReceive([&received](Peer&, Packet&& packet, uint8_t channelId) {
+        if (channelId == 1) received.push_back(packet.getData()[0]);
+    });
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while ((!connected || !server.getPeerCount()) && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( connected );
+    auto& peer = server.getPeers()[0];
+
+    const auto update = [](byte value, uint64_t key) {
+        const std::vector<byte> data{value};
+        Packet packet{data, Packet::Flag::Unreliable};
+        packet.setKey(key);
+        return packet;
+    };
+    const auto deliver = [&] {
+        const auto end = Clock::now() + std::chrono::milliseconds{100};
+        while (Clock::now() < end) {
+            server.service();
+            client.service(1_ms);
+        }
+    };
+
+    GIVEN( "Updates sent to the peer" ) {
+        for (auto i = 0; i < 30; ++i) peer.send(update(byte(i), i % 3), 1);
+        const std::vector<byte> plain{100};
+        peer.send({plain, Packet::Flag::Unreliable}, 1);
+
+        THEN( "Only the latest of every key and the unkeyed one go out" ) {
+            REQUIRE( server.getBacklog().packets == 4 );
+            deliver();
+            const std::vector<byte> expected{27, 28, 29, 100};
+            REQUIRE( received == expected );
+        }
+    }
+
+    GIVEN( "Updates broadcast" ) {
+        for (auto i = 0; i < 30; ++i) {
+            server.broadcast(update(byte(i), i % 3), 1);
+        }
+
+        THEN( "Only the latest of every key goes out" ) {
+            REQUIRE( server.getBacklog().packets == 3 );
+            deliver();
+            const std::vector<byte> expected{27, 28, 29};
+            REQUIRE( received == expected );
+        }
+    }
+
+    GIVEN( "Packet ENet refuses once it is drained" ) {
+        const std::vector<byte> data(1000, 1);
+        REQUIRE( peer.send({data, Packet::Flag::Unreliable}, 1) );
+        static_cast<ENetHost*>(server)->maximumPacketSize = 500;
+
+        THEN( "It is counted as dropped" ) {
+            REQUIRE( !peer.send({data, Packet::Flag::Unreliable}, 1) );
+            deliver();
+            REQUIRE( server.getBacklog().packets == 0 );
+            REQUIRE( peer.getDroppedPackets() == 1 );
+            REQUIRE( received.empty() );
+        }
+    }
+
+    GIVEN( "Update with the key of one handed over to ENet" ) {
+        peer.send(update(1, 0), 1);
+        server.service();
+        REQUIRE( server.getBacklog().packets == 0 );
+        peer.send(update(2, 0), 1);
+
+        THEN( "Both go out" ) {
+            REQUIRE( server.getBacklog().packets == 1 );
+            deliver();
+            const std::vector<byte> expected{1, 2};
+            REQUIRE( received == expected );
+        }
+    }
+}
+
+SCENARIO( "Saturated link", "[wenet][scheduler][latency]" ) {
+    GIVEN( "Bulk transfer on channel 2 and probes on channel 0" ) {
+        const auto plain = measureLatency(false);
+        const auto prioritised = measureLatency(true);
+
+        INFO( "Channel 0 median latency " << plain << "ms without and "
+              << prioritised << "ms with priorities" );
+
+        THEN( "Prioritised channel is not delayed by the bulk transfer" ) {
+            REQUIRE( prioritised * 4 < plain );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,102 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = Host::Clock;
+using namespace std::chrono_literals;
+
+constexpr auto port = 1255u;
+constexpr auto packets = 200u;
+
+SCENARIO( "Service with a deadline", "[wenet][service]" ) {
+    Host server{Address{port}, 1};
+    Host client{};
+    client.connect({"localhost", port}, 1);
+
+    auto connected = false;
+    client.onConnect([&connected](Peer&, uint32_t) { connected = true; });
+
+    const auto deadline = Clock::now() + 10s;
+    while ((!connected || !server.getPeerCount()) && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( connected );
+
+    std::vector<uint32_t> received;
+    auto slow = false;
+    server.onReceive([&](Peer&, Packet&& packet, uint8_t) {
+        uint32_t index;
+        std::memcpy(&index, packet.getData().data(), sizeof(index));
+        received.push_back(index);
+        if (slow) std::this_thread::sleep_for(1ms);
+    });
+
+    // everything is waiting in the server's socket before it is serviced
+    auto& peer = client.getPeers()[0];
+    for (auto i = 0u; i < packets; ++i) {
+        std::vector<byte> data(sizeof(i));
+        std::memcpy(data.data(), &i, sizeof(i));
+        peer.send({data});
+    }
+    client.flush();
+    std::this_thread::sleep_for(50ms);
+    REQUIRE( server.getBacklog().socket );
+
+    GIVEN( "Deadline that has passed already" ) {
+        server.service(Clock::now());
+
+        THEN( "One event is dispatched and the rest is left in the backlog" ) {
+            REQUIRE( received.size() == 1 );
+            REQUIRE( server.getBacklog().events == packets - 1 );
+        }
+
+        THEN( "Leftover events arrive in order on the next call" ) {
+            server.service(Clock::now() + 10s);
+            REQUIRE( received.size() == packets );
+            for (auto i = 0u; i < packets; ++i) REQUIRE( received[i] == i );
+            REQUIRE( server.getBacklog().events == 0 );
+        }
+    }
+
+    GIVEN( "Slow handler" ) {
+        slow = true;
+        const auto start = Clock::now();
+        server.service(start + 20ms);
+        const auto elapsed = Clock::now() - start;
+
+        THEN( "Dispatch stops at the deadline" ) {
+            REQUIRE( received.size() >= 1 );
+            REQUIRE( received.size() < packets );
+            REQUIRE( elapsed < 100ms );
+            REQUIRE( server.getBacklog().events == packets - received.size() );
+        }
+    }
+
+    GIVEN( "Packets held back by wenet" ) {
+        server.setChannelPriority(0, {0, 1}); // queues in wenet until service
+        auto& target = server.getPeers()[0];
+        const std::vector<byte> data(8);
+        for (auto i = 0; i < 3; ++i) target.send({data});
+
+        THEN( "They are in the backlog until service() sends them" ) {
+            REQUIRE( server.getBacklog().packets == 3 );
+            server.service(Clock::now() + 10s);
+            REQUIRE( server.getBacklog().packets == 0 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,112 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = Host::Clock;
+using namespace std::chrono_literals;
+
+constexpr auto port = 1258u;
+
+struct Handler {
+    void onConnect(Peer&, uint32_t data) { connected.push_back(data); }
+    void onReceive(Peer&, Packet&& packet, uint8_t channelId)
+    {
+        received.push_back(packet.getData()[0]);
+        channels.push_back(channelId);
+    }
+    void onDisconnect(size_t, uint32_t data) { disconnected.push_back(data); }
+
+    std::vector<uint32_t> connected;
+    std::vector<byte> received;
+    std::vector<uint8_t> channels;
+    std::vector<uint32_t> disconnected;
+};
+
+struct Counter {
+    void operator () (Peer&, Packet&&) { ++calls; }
+
+    unsigned calls = 0;
+};
+
+template <typename Server, typename Done>
+void run(Server& server, Host& client, Done done)
+{
+    const auto deadline = Clock::now() + 10s;
+    while (!done() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+}
+
+SCENARIO( "Static host", "[wenet][static]" ) {
+    using Server = StaticHost<Handler>;
+    Server server{Address{port}, 1};
+    auto callbacks = 0u;
+    server.onConnect([&callbacks](Peer&, uint32_t) { ++callbacks; });
+    server.onReceive([&callbacks](Peer&, Packet&&, uint8_t) { ++callbacks; });
+
+    Host client{};
+    auto& peer = client.connect({"localhost", port}, 2, 7);
+    auto& handler = server.getHandler();
+    run(server, client, [&handler] { return !handler.connected.empty(); });
+    REQUIRE( handler.connected == std::vector<uint32_t>{7} );
+
+    GIVEN( "Packets from the client" ) {
+        Counter route;
+        server.route(1, 'r', route);
+
+        const std::vector<byte> first{'a'}, routed{'r'}, second{'b'};
+        peer.send({first}, 1);
+        peer.send({routed}, 1);
+        peer.send({second}, 0);
+        client.flush();
+        run(server, client, [&handler] {
+            return handler.received.size() == 2;
+        });
+
+        THEN( "Routed ones go to the route, the rest to the handler" ) {
+            REQUIRE( route.calls == 1 );
+            const std::vector<byte> received{'a', 'b'};
+            const std::vector<uint8_t> channels{1, 0};
+            REQUIRE( handler.received == received );
+            REQUIRE( handler.channels == channels );
+        }
+    }
+
+    GIVEN( "Client disconnecting" ) {
+        peer.disconnect(9);
+        run(server, client, [&handler] {
+            return !handler.disconnected.empty();
+        });
+
+        THEN( "Handler is told" ) {
+            REQUIRE( handler.disconnected == std::vector<uint32_t>{9} );
+            REQUIRE( server.getPeerCount() == 0 );
+        }
+    }
+
+    THEN( "Callbacks of the base are not used" ) {
+        REQUIRE( callbacks == 0 );
+    }
+}
+
+SCENARIO( "Static host referring to a handler", "[wenet][static]" ) {
+    Handler handler;
+    StaticHost<Handler&> server{Address{port}, 1, handler};
+
+    THEN( "It is the same object" ) {
+        REQUIRE( &server.getHandler() == &handler );
+    }
+}
+
+} // \wenet
+
+} // \sq
@@ -0,0 +1,221 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/wenet.hpp"
+
+#include <chrono>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <algorithm>
+
+namespace sq {
+
+namespace wenet {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto port = 1252u;
+
+constexpr char source[] = "stream_source.bin";
+constexpr char destination[] = "stream_destination.bin";
+
+std::vector<byte> makeFile(const char* path, size_t size)
+{
+    std::vector<byte> data(size);
+    for (auto i = 0u; i < size; ++i) data[i] = byte(i * 7 + i / 251);
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return data;
+}
+
+std::vector<byte> readFile(const char* path)
+{
+    std::ifstream file{path, std::ios::binary};
+    using Iterator = std::istreambuf_iterator<char>;
+    return {Iterator{file}, Iterator{}};
+}
+
+SCENARIO( "Mapped file", "[wenet][stream]" ) {
+    GIVEN( "Existing file" ) {
+        const auto data = makeFile(source, 10000);
+        MappedFile file{source};
+
+        THEN( "Its contents are mapped" ) {
+            REQUIRE( file.getSize() == data.size() );
+            const auto mapped = file.getData();
+            REQUIRE( std::equal(mapped.begin(), mapped.end(), data.begin()) );
+        }
+    }
+
+    GIVEN( "Empty file" ) {
+        makeFile(source, 0);
+        MappedFile file{source};
+
+        THEN( "Nothing is mapped" ) {
+            REQUIRE( file.getSize() == 0 );
+            REQUIRE( file.getData().empty() );
+        }
+    }
+
+    GIVEN( "Missing file" ) {
+        std::remove(source);
+
+        THEN( "It cannot be mapped" ) {
+            REQUIRE_THROWS_AS( MappedFile{source}, MappedFile::Exception );
+        }
+    }
+
+    GIVEN( "File created for writing" ) {
+        {
+            MappedFile file{destination, 3000};
+            auto data = file.getData();
+            std::fill(data.begin(), data.end(), 0x5A);
+        }
+
+        THEN( "It has the size and contents written through the mapping" ) {
+            REQUIRE( readFile(destination) ==
+                     std::vector<byte>(3000, 0x5A) );
+        }
+    }
+
+    std::remove(source);
+    std::remove(destination);
+}
+
+SCENARIO( "Streams", "[wenet][stream]" ) {
+    // window of four chunks is refilled many times over the file
+    constexpr auto chunkSize = 4096u;
+    constexpr auto size = 64 * chunkSize + 123;
+    const auto data = makeFile(source, size);
+
+    Host server{Address{port}, 1};
+    server.setStreamChannel(1);
+    server.setStreamWindow({chunkSize, 4});
+
+    Host client{};
+    client.setStreamChannel(1);
+    client.connect({"localhost", port}, 2);
+
+    const auto deadline = Clock::now() + std::chrono::seconds{10};
+    while (!server.getPeerCount() && Clock::now() < deadline) {
+        server.service();
+        client.service(1_ms);
+    }
+    REQUIRE( server.getPeerCount() == 1 );
+    auto& peer = server.getPeers()[0];
+
+    std::vector<StreamProgress> sent;
+    server.onStreamSent([&sent](Peer&, const StreamProgress& progress) {
+        sent.push_back(progress);
+    });
+
+    std::vector<uint32_t> begun;
+    std::vector<byte> buffer(size);
+    auto accept = true;
+    client.onStreamBegin([&](Peer&, IncomingStream& stream) {
+        begun.push_back(stream.getId());
+        if (!accept) return;
+        if (begun.size() > 1) stream.accept(destination);
+        else stream.accept({buffer.data(), std::ptrdiff_t(size)});
+    });
+
+    std::vector<StreamProgress> received;
+    client.onStreamReceived([&received](Peer&, const StreamProgress& progress) {
+        received.push_back(progress);
+    });
+
+    const auto finished = [&](uint32_t id) {
+        return std::any_of(sent.begin(), sent.end(),
+                           [id](const StreamProgress& progress) {
+            return progress.id == id && progress.done == progress.total;
+        });
+    };
+    const auto run = [&](uint32_t id) {
+        const auto deadline = Clock::now() + std::chrono::seconds{10};
+        while (!finished(id) && Clock::now() < deadline) {
+            server.service();
+            client.service(1_ms);
+        }
+        return finished(id);
+    };
+
+    GIVEN( "Stream into a buffer" ) {
+        const std::vector<byte> info{1, 2, 3};
+        const auto id = peer.sendStream(source, {info.data(), 3});
+        REQUIRE( run(id) );
+
+        THEN( "Receiver gets the whole file" ) {
+            REQUIRE( begun == std::vector<uint32_t>{id} );
+            REQUIRE( buffer == data );
+            REQUIRE( received.back().done == size );
+            REQUIRE( received.back().total == size );
+        }
+
+        THEN( "Sender reports acknowledged bytes as they grow" ) {
+            REQUIRE( sent.size() > 1 );
+            for (auto i = 1u; i < sent.size(); ++i) {
+                REQUIRE( sent[i].done > sent[i - 1].done );
+                REQUIRE( sent[i].total == size );
+            }
+        }
+    }
+
+    GIVEN( "Two streams to the same peer" ) {
+        const auto first = peer.sendStream(source);
+        const auto second = peer.sendStream(source);
+        REQUIRE( run(second) );
+
+        THEN( "The second one follows the first one into a file" ) {
+            REQUIRE( begun == std::vector<uint32_t>({first, second}) );
+            REQUIRE( finished(first) );
+            REQUIRE( buffer == data );
+            REQUIRE( readFile(destination) == data );
+        }
+    }
+
+    GIVEN( "Stream that is not accepted" ) {
+        accept = false;
+        const auto id = peer.sendStream(source);
+        REQUIRE( run(id) );
+
+        THEN( "Its data is discarded" ) {
+            REQUIRE( begun.size() == 1 );
+            REQUIRE( received.empty() );
+            REQUIRE( buffer == std::vector<byte>(size) );
+        }
+    }
+
+    GIVEN( "Peer disconnected in the middle of a stream" ) {
+        peer.sendStream(source);
+        const auto deadline = Clock::now() + std::chrono::seconds{10};
+        while (sent.empty() && Clock::now() < deadline) {
+            server.service();
+            client.service(1_ms);
+        }
+        REQUIRE( !sent.empty() );
+        peer.disconnectNow();
+
+        const auto reported = sent.size();
+        for (auto i = 0; i < 50; ++i) {
+            server.service();
+            client.service(1_ms);
+        }
+
+        THEN( "Stream is aborted and released chunks are not reported" ) {
+            REQUIRE( sent.size() == reported );
+            REQUIRE( sent.back().done < size );
+            REQUIRE( !received.empty() );
+            REQUIRE( received.back().done < size );
+        }
+    }
+
+    std::remove(source);
+    std::remove(destination);
+}
+
+} // \wenet
+
+} // \sq
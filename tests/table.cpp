@@ -0,0 +1,75 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wenet/table.hpp"
+
+#include <vector>
+
+namespace sq {
+
+namespace wenet {
+
+SCENARIO( "Peer table", "[wenet][table]" ) {
+    using Metric = PeerTable::Metric;
+
+    std::vector<ENetPeer> peers(8);
+    ENetHost host{};
+    host.peers = peers.data();
+    host.peerCount = peers.size();
+
+    for (auto i = 0u; i < peers.size(); ++i) {
+        peers[i].state = ENET_PEER_STATE_CONNECTED;
+        peers[i].roundTripTime = i * 50;
+        peers[i].packetLoss = i;
+    }
+    peers[7].state = ENET_PEER_STATE_DISCONNECTED;
+
+    PeerTable table{peers.size()};
+    for (auto i = 0u; i < peers.size(); ++i) table.setManaged(i, true);
+    table.setManaged(6, false);
+
+    PeerTable::Slots slots;
+
+    WHEN( "Table is not refreshed" ) {
+        THEN( "Nothing is found" ) {
+            table.findAbove(Metric::RoundTripTime, 0, slots);
+            REQUIRE( slots.empty() );
+        }
+    }
+
+    WHEN( "Table is refreshed" ) {
+        table.refresh(host);
+
+        THEN( "Columns mirror the peers" ) {
+            REQUIRE( table.get(Metric::RoundTripTime)[3] == 150 );
+            REQUIRE( table.get(Metric::PacketLoss)[5] == 5 );
+            REQUIRE( table.getStates()[7] == ENET_PEER_STATE_DISCONNECTED );
+        }
+
+        THEN( "Only connected managed peers are found" ) {
+            table.findAbove(Metric::RoundTripTime, 100, slots);
+            REQUIRE( slots == (PeerTable::Slots{3, 4, 5}) );
+            REQUIRE( table.countAbove(Metric::RoundTripTime, 100) == 3 );
+
+            table.findBelow(Metric::PacketLoss, 2, slots);
+            REQUIRE( slots == (PeerTable::Slots{0, 1}) );
+        }
+
+        THEN( "Peers stop being found once unmanaged" ) {
+            table.setManaged(4, false);
+            table.findAbove(Metric::RoundTripTime, 100, slots);
+            REQUIRE( slots == (PeerTable::Slots{3, 5}) );
+        }
+
+        THEN( "Changes are seen after the next refresh only" ) {
+            peers[0].roundTripTime = 500;
+            REQUIRE( table.countAbove(Metric::RoundTripTime, 400) == 0 );
+            table.refresh(host);
+            REQUIRE( table.countAbove(Metric::RoundTripTime, 400) == 1 );
+        }
+    }
+}
+
+} // \wenet
+
+} // \sq